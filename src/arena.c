@@ -0,0 +1,68 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "arena.h"
+#include "i18n.h"
+
+/* allocate arena of size bytes */
+int arena_init(setk_arena_t *arena, size_t size) {
+    arena->size = 0;
+    arena->used = 0;
+
+    if (posix_memalign((void **) &arena->base, ARENA_ALIGN, size) != 0) {
+        arena->base = NULL;
+        return 1;
+    }
+
+    arena->size = size;
+
+    return 0;
+}
+
+/* get buffer of count samples */
+real_t *arena_alloc_real(setk_arena_t *arena, size_t count) {
+    size_t len = ARENA_SIZE_REAL(count);
+    real_t *ptr;
+
+    /* arena is sized for the worst case, so this is a programming error */
+    if (arena->used + len > arena->size) {
+        fprintf(stderr, _("%s : Error: scratch arena is too small\n"), __func__);
+        abort();
+    }
+
+    ptr = (real_t *) (arena->base + arena->used);
+    arena->used += len;
+
+    return ptr;
+}
+
+/* release all buffers */
+void arena_reset(setk_arena_t *arena) {
+    arena->used = 0;
+}
+
+/* free memory of arena */
+void arena_free(setk_arena_t *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
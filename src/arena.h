@@ -0,0 +1,37 @@
+/********************************************************************
+ function: Scratch Arena
+ contains: bump allocator for per-frame buffers, memory is allocated
+           once when stream is opened and reused for every frame
+ ********************************************************************/
+
+#ifndef HAVE_ARENA_H
+#define HAVE_ARENA_H
+
+#include "common.h"
+
+/* every buffer from arena starts on cache line, which also satisfies
+ * alignment of FFTW plans made for fftw_alloc_real() buffers */
+#define ARENA_ALIGN                         64
+
+typedef struct setk_arena_t {
+    char *base;
+    size_t size;
+    size_t used;
+} setk_arena_t;
+
+/* number of bytes arena needs for buffer of count samples */
+#define ARENA_SIZE_REAL(count)               ((((count) * sizeof(real_t) + ARENA_ALIGN - 1) / ARENA_ALIGN) * ARENA_ALIGN)
+
+/* allocate arena of size bytes, returns 0 on success, arena is empty when it fails */
+extern int arena_init(setk_arena_t *arena, size_t size);
+
+/* get buffer of count samples, its content is undefined */
+extern real_t *arena_alloc_real(setk_arena_t *arena, size_t count);
+
+/* release all buffers, called at the beginning of each frame */
+extern void arena_reset(setk_arena_t *arena);
+
+/* free memory of arena */
+extern void arena_free(setk_arena_t *arena);
+
+#endif
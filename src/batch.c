@@ -0,0 +1,306 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "batch.h"
+#include "stream.h"
+#include "i18n.h"
+
+/* files of one batch, workers take them in order */
+typedef struct batch_queue_t {
+    const setk_options_t *opts;
+    char **input_files;
+    char **output_files;
+    int count;
+    int next;                               /* index of next file to process */
+    int failed;
+    pthread_mutex_t lock;
+} batch_queue_t;
+
+/* add file name to the end of list */
+static void append_file(batch_queue_t *queue, const char *filename, int *capacity);
+
+/* read list of files from directory */
+static int read_directory(batch_queue_t *queue, const char *path);
+
+/* read list of files from list file, one file name per line */
+static int read_list_file(batch_queue_t *queue, const char *path);
+
+/* output file name of given input file */
+static char *batch_output_file_name(const setk_options_t *args, const char *input_filename);
+
+/* compare file names for qsort() */
+static int compare_file_names(const void *a, const void *b);
+
+/* check that every file of batch has its own output file, returns 0 if it does */
+static int check_output_files(const batch_queue_t *queue);
+
+/* free lists of input and output files */
+static void free_files(batch_queue_t *queue);
+
+/* batch worker thread */
+static void *batch_worker(void *arg);
+
+/* process all files of batch */
+int process_batch(const setk_options_t *args) {
+    batch_queue_t queue;
+    pthread_t *threads;
+    struct stat st;
+    int nthreads;
+
+    memset((void *) &queue, 0, sizeof(queue));
+    queue.opts = args;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    if (stat(args->batch_path, &st) != 0) {
+        printf(_("Error: Unable to open batch '%s': %s\n"), args->batch_path, strerror(errno));
+        return 1;
+    }
+
+    if ((S_ISDIR(st.st_mode) ? read_directory(&queue, args->batch_path) :
+         read_list_file(&queue, args->batch_path)) != 0)
+        return 1;
+
+    if (queue.count == 0) {
+        printf(_("Error: Batch '%s' contains no files.\n"), args->batch_path);
+        return 1;
+    }
+
+    queue.output_files = (char **) malloc(sizeof(*queue.output_files) * queue.count);
+    if (queue.output_files == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+    for (int i = 0; i < queue.count; ++i)
+        queue.output_files[i] = batch_output_file_name(args, queue.input_files[i]);
+
+    /* workers would write the same output at once, e.g. of inputs with the same name in several directories */
+    if (check_output_files(&queue) != 0) {
+        free_files(&queue);
+        pthread_mutex_destroy(&queue.lock);
+        return 1;
+    }
+
+    nthreads = MIN (args->jobs, queue.count);
+    if (args->verbosity)
+        printf(_("Processing %d files with %d workers.\n"), queue.count, nthreads);
+
+    threads = (pthread_t *) malloc(sizeof(*threads) * nthreads);
+    if (threads == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    for (int t = 0; t < nthreads; ++t) {
+        if (pthread_create(&threads[t], NULL, batch_worker, &queue) != 0) {
+            printf(_("\nError: Unable to create batch worker: %s\n"), strerror(errno));
+            exit(1);
+        }
+    }
+
+    for (int t = 0; t < nthreads; ++t)
+        pthread_join(threads[t], NULL);
+
+    if (args->verbosity || queue.failed > 0)
+        printf(_("Finished batch: %d of %d files failed.\n"), queue.failed, queue.count);
+
+    free_files(&queue);
+    free(threads);
+    pthread_mutex_destroy(&queue.lock);
+
+    return queue.failed;
+}
+
+/* add file name to the end of list */
+static void append_file(batch_queue_t *queue, const char *filename, int *capacity) {
+    if (queue->count == *capacity) {
+        *capacity = (*capacity == 0) ? 64 : 2 * (*capacity);
+        queue->input_files = (char **) realloc(queue->input_files, sizeof(*queue->input_files) * (*capacity));
+        if (queue->input_files == NULL) {
+            printf(_("\nError: realloc() failed: %s\n"), strerror(errno));
+            exit(1);
+        }
+    }
+
+    queue->input_files[queue->count++] = strdup(filename);
+}
+
+/* read list of files from directory */
+static int read_directory(batch_queue_t *queue, const char *path) {
+    struct dirent **entries;
+    struct stat st;
+    int capacity = 0;
+    int n;
+
+    /* entries are sorted, so that the order of processing is reproducible */
+    if ((n = scandir(path, &entries, NULL, alphasort)) < 0) {
+        printf(_("Error: Unable to read directory '%s': %s\n"), path, strerror(errno));
+        return 1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        char *filename = (char *) malloc(strlen(path) + strlen(entries[i]->d_name) + 2);
+
+        if (filename == NULL) {
+            printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+            exit(1);
+        }
+        sprintf(filename, "%s/%s", path, entries[i]->d_name);
+
+        /* hidden files and subdirectories are skipped */
+        if (entries[i]->d_name[0] != '.' && stat(filename, &st) == 0 && S_ISREG(st.st_mode))
+            append_file(queue, filename, &capacity);
+
+        free(filename);
+        free(entries[i]);
+    }
+    free(entries);
+
+    return 0;
+}
+
+/* read list of files from list file */
+static int read_list_file(batch_queue_t *queue, const char *path) {
+    FILE *f;
+    char buf[4096];
+    int capacity = 0;
+
+    if ((f = fopen(path, "r")) == NULL) {
+        printf(_("Error: Unable to open batch list '%s': %s\n"), path, strerror(errno));
+        return 1;
+    }
+
+    while (fgets(buf, sizeof(buf), f)) {
+        char *p = &buf[strlen(buf) - 1];
+
+        /* Chop off \n and \r and white space */
+        while (p >= buf && (*p == '\n' || *p == '\r' || *p == '\t' || *p == ' '))
+            *p-- = '\0';
+
+        /* Ignore comments and empty lines */
+        if (strlen(buf) == 0 || buf[0] == '#')
+            continue;
+
+        append_file(queue, buf, &capacity);
+    }
+    fclose(f);
+
+    return 0;
+}
+
+/* output file name of given input file */
+static char *batch_output_file_name(const setk_options_t *args, const char *input_filename) {
+    const char *basename;
+    char *output_filename;
+
+    /* without output directory, _enhanced is appended to input file name */
+    if (args->output_filename == NULL)
+        return (char *) create_output_file_name(input_filename);
+
+    basename = strrchr(input_filename, '/');
+    basename = (basename == NULL) ? input_filename : basename + 1;
+
+    output_filename = (char *) malloc(strlen(args->output_filename) + strlen(basename) + 2);
+    if (output_filename == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+    sprintf(output_filename, "%s/%s", args->output_filename, basename);
+
+    return output_filename;
+}
+
+/* compare file names for qsort() */
+static int compare_file_names(const void *a, const void *b) {
+    return strcmp(*(const char * const *) a, *(const char * const *) b);
+}
+
+/* check that every file of batch has its own output file, equal names are adjacent once sorted */
+static int check_output_files(const batch_queue_t *queue) {
+    const char **names = (const char **) malloc(sizeof(*names) * queue->count);
+    int status = 0;
+
+    if (names == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    memcpy((void *) names, (void *) queue->output_files, sizeof(*names) * queue->count);
+    qsort((void *) names, (size_t) queue->count, sizeof(*names), compare_file_names);
+
+    for (int i = 1; i < queue->count; ++i) {
+        if (strcmp(names[i - 1], names[i]) == 0 && (i == 1 || strcmp(names[i - 2], names[i]) != 0)) {
+            printf(_("Error: Several files of batch would be written to '%s'.\n"), names[i]);
+            status = 1;
+        }
+    }
+    free(names);
+
+    return status;
+}
+
+/* free lists of input and output files */
+static void free_files(batch_queue_t *queue) {
+    for (int i = 0; i < queue->count; ++i) {
+        free(queue->input_files[i]);
+        free(queue->output_files[i]);
+    }
+    free(queue->input_files);
+    free(queue->output_files);
+}
+
+/* batch worker thread */
+static void *batch_worker(void *arg) {
+    batch_queue_t *queue = (batch_queue_t *) arg;
+    setk_stream_t *stream = NULL; /* reused for consecutive files of the same format */
+    int index;
+
+    for (;;) {
+        pthread_mutex_lock(&queue->lock);
+        index = queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        if (index >= queue->count)
+            break;
+
+        if (queue->opts->verbosity)
+            printf(_("[%d/%d] %s -> %s\n"), index + 1, queue->count, queue->input_files[index],
+                   queue->output_files[index]);
+
+        if (is_same_file(queue->input_files[index], queue->output_files[index])) {
+            printf(_("Error: input and output are the same file: '%s'\n"), queue->input_files[index]);
+        }
+        else if (process_file(queue->opts, queue->input_files[index], queue->output_files[index],
+                              &stream) == 0) {
+            continue;
+        }
+
+        pthread_mutex_lock(&queue->lock);
+        queue->failed++;
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    setk_stream_destroy(stream);
+
+    return NULL;
+}
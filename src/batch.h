@@ -0,0 +1,19 @@
+/********************************************************************
+ function: Batch Processing
+ contains: processing of many audio files by a pool of worker threads
+ ********************************************************************/
+
+#ifndef HAVE_BATCH_H
+#define HAVE_BATCH_H
+
+#include "common.h"
+#include "toolkit.h"
+
+/* maximum number of batch workers */
+#define BATCH_JOBS_MAX                      64
+
+/* process all files listed in args->batch_path, which is a list file
+ * (one file name per line) or a directory, returns number of failed files */
+extern int process_batch(const setk_options_t *args);
+
+#endif
@@ -0,0 +1,535 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* setk_bench - throughput of every sound enhancement, noise estimation and window
+ * combination on synthetic noisy speech-like corpora */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "config.h"
+#include "common.h"
+#include "processor.h"
+#include "snd_enhance.h"
+#include "noise_est.h"
+#include "window.h"
+#include "fft.h"
+#include "i18n.h"
+
+/* maximum number of channels of synthetic corpus */
+#define BENCH_CHANNELS_MAX                  8
+
+/* SNR of synthetic corpora in dB */
+#define BENCH_SNR                           5.0
+
+/* command line rules */
+enum bench_arguments_t {
+    ARG_DURATION,
+    ARG_SAMPLERATE,
+    ARG_CHANNELS,
+    ARG_SIGNAL,
+    ARG_SND_ENH,
+    ARG_NOISE_EST,
+    ARG_WINDOW_TYPE,
+    ARG_FRAME_DURATION,
+    ARG_OVERLAP,
+    ARG_CHANNEL_THREADS,
+    ARG_WISDOM,
+    ARG_PLAN_EFFORT,
+    ARG_CSV
+};
+
+/* generator of synthetic signal, speech is written into speech, noise into noise */
+typedef void (*bench_signal_func_t)(real_t *speech, real_t *noise, size_t frames, int samplerate);
+
+typedef struct bench_signal_t {
+    const char *name;
+    bench_signal_func_t generate;
+} bench_signal_t;
+
+/* options of benchmark */
+typedef struct bench_options_t {
+    double duration;                        /* --duration option, seconds of every corpus */
+    int samplerate;                         /* --samplerate option, 0 runs all rates */
+    int channels;                           /* --channels option, 0 runs 1 and 2 channels */
+    const char *signal;                     /* --signal option, NULL runs all signals */
+    const char *snd_enhance_type;           /* --snd-enhance option, NULL runs all algorithms */
+    const char *noise_est_type;             /* --noise-est option, NULL runs all algorithms */
+    const char *window_type;                /* --window option, NULL runs all windows */
+    int frame_duration;                     /* --frame-dur option */
+    int overlap;                            /* --overlap option */
+    int channel_threads;                    /* --channel-threads option */
+    bool csv;                               /* --csv option */
+} bench_options_t;
+
+/* result of one combination */
+typedef struct bench_result_t {
+    unsigned long hops;
+    unsigned long frames;                   /* audio frames of all hops, e.g. samples of one channel */
+    double seconds;                         /* processing time */
+} bench_result_t;
+
+static const struct option long_options[] = {
+        {"duration",    required_argument, NULL, ARG_DURATION},
+        {"samplerate",  required_argument, NULL, ARG_SAMPLERATE},
+        {"channels",    required_argument, NULL, ARG_CHANNELS},
+        {"signal",      required_argument, NULL, ARG_SIGNAL},
+        {"snd-enhance", required_argument, NULL, ARG_SND_ENH},
+        {"noise-est",   required_argument, NULL, ARG_NOISE_EST},
+        {"window",      required_argument, NULL, ARG_WINDOW_TYPE},
+        {"frame-dur",   required_argument, NULL, ARG_FRAME_DURATION},
+        {"overlap",     required_argument, NULL, ARG_OVERLAP},
+        {"channel-threads", required_argument, NULL, ARG_CHANNEL_THREADS},
+        {"wisdom",      required_argument, NULL, ARG_WISDOM},
+        {"plan-effort", required_argument, NULL, ARG_PLAN_EFFORT},
+        {"csv",         no_argument,       NULL, ARG_CSV},
+        {"help",        no_argument,       NULL, 'h'},
+        {NULL,          no_argument,       NULL, 0}
+};
+
+static const int bench_samplerates[] = {8000, 16000, 44100, 48000};
+
+static const int bench_channels[] = {1, 2};
+
+static const char *bench_snd_enhance_types[] = {"specsub", "mmse", "wiener-as", "wiener-iter", "residual"};
+
+static const char *bench_noise_est_types[] = {"vad", "hirsch", "doblinger", "mcra", "mcra2"};
+
+static const char *bench_window_types[] = {"hamming", "hann", "blackman", "bartlett", "triangular", "rectangular",
+                                           "nuttall"};
+
+/* synthetic signals */
+static void signal_tones(real_t *speech, real_t *noise, size_t frames, int samplerate);
+
+static void signal_am_noise(real_t *speech, real_t *noise, size_t frames, int samplerate);
+
+static void signal_babble(real_t *speech, real_t *noise, size_t frames, int samplerate);
+
+static const bench_signal_t bench_signals[] = {
+        {"tones",    signal_tones},
+        {"am-noise", signal_am_noise},
+        {"babble",   signal_babble},
+};
+
+/* state of pseudo random generator, corpora are the same on every run and machine */
+static uint32_t bench_seed;
+
+/* uniform pseudo random number in range <-1, 1) */
+static double bench_random(void);
+
+/* add harmonic voice with fundamental f0, syllables of given rate modulate its amplitude */
+static void add_voice(real_t *data, size_t frames, int samplerate, double f0, double syllable_rate,
+                      double phase, double gain);
+
+/* create interleaved corpus of signal, noise of every channel is different */
+static real_t *create_corpus(const bench_signal_t *signal, size_t frames, int channels, int samplerate);
+
+/* enhance corpus with one combination of algorithms */
+static bench_result_t run_combination(const bench_options_t *opts, const real_t *corpus, size_t frames,
+                                      int channels, int samplerate, const char *snd_enhance_type,
+                                      const char *noise_est_type, const char *window_type);
+
+/* monotonic clock in seconds */
+static double bench_clock(void);
+
+/* buffer of samples set to zero, benchmark exits when it cannot be allocated */
+static real_t *bench_buffer(size_t size);
+
+/* Print usage */
+static void help(const char *argv0) {
+
+    printf(_(
+                   "\nSound Enhancement Toolkit Benchmark\n"
+                           "-----------------------------------\n\n"
+                           "Usage: %s [options]\n\n"
+                           "Every combination of sound enhancement, noise estimation and window function\n"
+                           "is run on synthetic noisy corpora, hops per second and real-time factor are reported.\n\n"
+                           "  -h, --help                  Show this help\n\n"
+                           "      --duration              Seconds of every corpus, at least 0.1, default 2\n"
+                           "      --samplerate            Only this samplerate, default 8000, 16000, 44100 and 48000 Hz\n"
+                           "      --channels              Only this number of channels, range <1 - 8>, default 1 and 2\n"
+                           "      --signal                Only this signal: tones, am-noise or babble\n"
+                           "      --snd-enhance           Only this sound enhancement algorithm\n"
+                           "      --noise-est             Only this noise estimation algorithm\n"
+                           "      --window                Only this window function\n"
+                           "      --frame-dur             Duration of speech frame in milliseconds, default 20\n"
+                           "      --overlap               Overlap of adjacent frames in percent, default 50\n"
+                           "      --channel-threads       Number of threads processing channels, default 1\n"
+                           "      --wisdom                FFTW wisdom cache file\n"
+                           "      --plan-effort           FFT planning effort: estimate, measure or patient\n"
+                           "      --csv                   Print results as comma separated values\n\n"
+           ), argv0);
+}
+
+int main(int argc, char **argv) {
+    bench_options_t opts = {
+            .duration = 2.0,
+            .samplerate = 0,
+            .channels = 0,
+            .signal = NULL,
+            .snd_enhance_type = NULL,
+            .noise_est_type = NULL,
+            .window_type = NULL,
+            .frame_duration = 20,
+            .overlap = 50,
+            .channel_threads = 1,
+            .csv = false,
+    };
+    const char *wisdom_filename = NULL;
+    unsigned plan_flags = FFTW_MEASURE;
+    double total_seconds = 0, total_audio = 0;
+    int opt = 0;
+    int long_index = 0;
+
+    while ((opt = getopt_long(argc, argv, "h", long_options, &long_index)) != -1) {
+        switch (opt) {
+            case ARG_DURATION:
+                opts.duration = atof(optarg);
+                break;
+            case ARG_SAMPLERATE:
+                opts.samplerate = atoi(optarg);
+                break;
+            case ARG_CHANNELS:
+                opts.channels = atoi(optarg);
+                break;
+            case ARG_SIGNAL:
+                opts.signal = optarg;
+                break;
+            case ARG_SND_ENH:
+                opts.snd_enhance_type = optarg;
+                break;
+            case ARG_NOISE_EST:
+                opts.noise_est_type = optarg;
+                break;
+            case ARG_WINDOW_TYPE:
+                opts.window_type = optarg;
+                break;
+            case ARG_FRAME_DURATION:
+                opts.frame_duration = atoi(optarg);
+                break;
+            case ARG_OVERLAP:
+                opts.overlap = atoi(optarg);
+                break;
+            case ARG_CHANNEL_THREADS:
+                opts.channel_threads = atoi(optarg);
+                break;
+            case ARG_WISDOM:
+                wisdom_filename = optarg;
+                break;
+            case ARG_PLAN_EFFORT:
+                if (fft_parse_plan_effort(optarg, &plan_flags) != 0) {
+                    printf(_("Error: Unknown FFT planning effort '%s'.\n"), optarg);
+                    exit(1);
+                }
+                break;
+            case ARG_CSV:
+                opts.csv = true;
+                break;
+            case 'h':
+                help(argv[0]);
+                return 0;
+            default:
+                help(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (opts.duration < 0.1 || opts.samplerate < 0 || opts.channels < 0 || opts.channels > BENCH_CHANNELS_MAX ||
+        opts.overlap < 0 || opts.overlap > 99 || opts.frame_duration < 10 || opts.frame_duration > 30 ||
+        opts.channel_threads < 1 || opts.channel_threads > CHANNEL_THREADS_MAX) {
+        puts(_("Error: Benchmark parameter is out of range, see --help."));
+        exit(1);
+    }
+
+    fft_set_plan_flags(plan_flags);
+    if (wisdom_filename != NULL)
+        fft_wisdom_import(wisdom_filename);
+
+    if (opts.csv)
+        puts("signal,samplerate,channels,snd_enhance,noise_est,window,hops,seconds,hops_per_second,"
+             "frames_per_second,rtf");
+    else
+        printf("%-9s %6s %2s %-12s %-10s %-12s %10s %12s %8s\n", "signal", "rate", "ch", "snd-enhance", "noise-est",
+               "window", "hops/s", "frames/s", "RTF");
+
+    for (size_t s = 0; s < ARRAY_LEN(bench_signals); ++s) {
+        if (opts.signal != NULL && strcmp(opts.signal, bench_signals[s].name) != 0)
+            continue;
+
+        for (size_t r = 0; r < ARRAY_LEN(bench_samplerates); ++r) {
+            int samplerate = opts.samplerate ? opts.samplerate : bench_samplerates[r];
+            size_t frames = (size_t) (opts.duration * samplerate);
+
+            for (size_t c = 0; c < ARRAY_LEN(bench_channels); ++c) {
+                int channels = opts.channels ? opts.channels : bench_channels[c];
+                real_t *corpus = create_corpus(&bench_signals[s], frames, channels, samplerate);
+
+                for (size_t e = 0; e < ARRAY_LEN(bench_snd_enhance_types); ++e) {
+                    if (opts.snd_enhance_type != NULL &&
+                        strcmp(opts.snd_enhance_type, bench_snd_enhance_types[e]) != 0)
+                        continue;
+
+                    for (size_t n = 0; n < ARRAY_LEN(bench_noise_est_types); ++n) {
+                        if (opts.noise_est_type != NULL && strcmp(opts.noise_est_type, bench_noise_est_types[n]) != 0)
+                            continue;
+
+                        for (size_t w = 0; w < ARRAY_LEN(bench_window_types); ++w) {
+                            bench_result_t result;
+                            double rtf;
+
+                            if (opts.window_type != NULL && strcmp(opts.window_type, bench_window_types[w]) != 0)
+                                continue;
+
+                            result = run_combination(&opts, corpus, frames, channels, samplerate,
+                                                     bench_snd_enhance_types[e], bench_noise_est_types[n],
+                                                     bench_window_types[w]);
+                            /* real-time factor is processing time per second of processed audio */
+                            rtf = result.seconds * samplerate / result.frames;
+                            total_seconds += result.seconds;
+                            total_audio += (double) result.frames / samplerate;
+
+                            if (opts.csv)
+                                printf("%s,%d,%d,%s,%s,%s,%lu,%.6f,%.1f,%.1f,%.6f\n", bench_signals[s].name,
+                                       samplerate, channels, bench_snd_enhance_types[e], bench_noise_est_types[n],
+                                       bench_window_types[w], result.hops, result.seconds,
+                                       result.hops / result.seconds, result.frames / result.seconds, rtf);
+                            else
+                                printf("%-9s %6d %2d %-12s %-10s %-12s %10.1f %12.1f %8.5f\n", bench_signals[s].name,
+                                       samplerate, channels, bench_snd_enhance_types[e], bench_noise_est_types[n],
+                                       bench_window_types[w], result.hops / result.seconds,
+                                       result.frames / result.seconds, rtf);
+                            fflush(stdout);
+                        }
+                    }
+                }
+
+                free(corpus);
+                if (opts.channels)
+                    break;
+            }
+            if (opts.samplerate)
+                break;
+        }
+    }
+
+    if (!opts.csv && total_audio > 0)
+        printf(_("\nTotal: %.1f s of audio in %.3f s, real-time factor %.5f\n"), total_audio, total_seconds,
+               total_seconds / total_audio);
+
+    if (wisdom_filename != NULL)
+        fft_wisdom_export(wisdom_filename);
+
+    fft_plans_cleanup();
+    window_tables_cleanup();
+
+    return 0;
+}
+
+/* enhance corpus with one combination of algorithms, setup is not timed */
+static bench_result_t run_combination(const bench_options_t *opts, const real_t *corpus, size_t frames,
+                                      int channels, int samplerate, const char *snd_enhance_type,
+                                      const char *noise_est_type, const char *window_type) {
+    bench_result_t result = {0, 0, 0.0};
+    setk_processor_t *processor;
+    setk_status_t status;
+    const fft_plans_t *plans;
+    size_t window_size, fft_size, pos;
+    real_t *multi_data, *prev_multi_data;
+    int noverlap, nslide;
+    double start;
+
+    /* window size is even, like in toolkit */
+    window_size = WINDOW_SIZE(opts->frame_duration, samplerate);
+    if (window_size % 2 != 0)
+        window_size += 1;
+    fft_size = OPTIMAL_FFT_SIZE(window_size);
+
+    if (fft_size > FFT_MAX) {
+        printf(_("Error: FFT size %d of %d Hz is greater than %d, use shorter --frame-dur.\n"), (int) fft_size,
+               samplerate, FFT_MAX);
+        exit(1);
+    }
+
+    noverlap = (int) floor(window_size * opts->overlap / 100);
+    nslide = (int) window_size - noverlap;
+
+    if ((plans = fft_plans_get(fft_size)) == NULL) {
+        printf(_("Error: %s.\n"), setk_strerror(SETK_ERROR_MEMORY));
+        exit(1);
+    }
+
+    if ((status = processor_create(&processor, fft_size, window_size, opts->overlap, channels, samplerate,
+                                   parse_window_type(window_type, false),
+                                   parse_snd_enhance_type(snd_enhance_type, false),
+                                   parse_noise_est_type(noise_est_type, false), plans->fft_forw, plans->fft_back,
+                                   opts->channel_threads)) != SETK_OK) {
+        printf(_("Error: %s.\n"), setk_strerror(status));
+        exit(1);
+    }
+
+    multi_data = bench_buffer(window_size * channels);
+    prev_multi_data = bench_buffer((size_t) noverlap * channels);
+
+    /* hops are formed like in toolkit, corpus is the input file */
+    start = bench_clock();
+
+    memcpy((void *) multi_data, (void *) corpus, sizeof(*multi_data) * window_size * channels);
+    memcpy((void *) prev_multi_data, (void *) (multi_data + nslide * channels),
+           sizeof(*multi_data) * noverlap * channels);
+
+    for (pos = window_size; pos + nslide <= frames; pos += nslide) {
+        processor_run(processor, multi_data);
+        result.hops++;
+        result.frames += nslide;
+
+        memcpy((void *) (multi_data + noverlap * channels), (void *) (corpus + pos * channels),
+               sizeof(*multi_data) * nslide * channels);
+        memcpy((void *) multi_data, (void *) prev_multi_data, sizeof(*prev_multi_data) * noverlap * channels);
+        memcpy((void *) prev_multi_data, (void *) (multi_data + nslide * channels),
+               sizeof(*multi_data) * noverlap * channels);
+    }
+
+    result.seconds = bench_clock() - start;
+
+    processor_destroy(processor);
+    free(multi_data);
+    free(prev_multi_data);
+
+    return result;
+}
+
+/* create interleaved corpus of signal, speech is mixed with noise at BENCH_SNR */
+static real_t *create_corpus(const bench_signal_t *signal, size_t frames, int channels, int samplerate) {
+    real_t *corpus = bench_buffer(frames * channels);
+    real_t *speech = bench_buffer(frames);
+    real_t *noise = bench_buffer(frames);
+    double speech_energy, noise_energy, noise_gain, peak = 0;
+
+    for (int ch = 0; ch < channels; ++ch) {
+        /* speech is the same in all channels, noise differs */
+        bench_seed = 0x5e7c0001u + (uint32_t) ch;
+        memset((void *) speech, 0, sizeof(*speech) * frames);
+        memset((void *) noise, 0, sizeof(*noise) * frames);
+        signal->generate(speech, noise, frames, samplerate);
+
+        speech_energy = noise_energy = 1e-12;
+        for (size_t i = 0; i < frames; ++i) {
+            speech_energy += speech[i] * speech[i];
+            noise_energy += noise[i] * noise[i];
+        }
+        noise_gain = sqrt(speech_energy / noise_energy / pow(10, BENCH_SNR / 10));
+
+        for (size_t i = 0; i < frames; ++i) {
+            corpus[i * channels + ch] = speech[i] + noise_gain * noise[i];
+            peak = MAX(peak, fabs(corpus[i * channels + ch]));
+        }
+    }
+
+    /* normalize to -6 dBFS */
+    for (size_t i = 0; i < frames * channels; ++i)
+        corpus[i] *= 0.5 / peak;
+
+    free(speech);
+    free(noise);
+
+    return corpus;
+}
+
+/* steady tones in white noise */
+static void signal_tones(real_t *speech, real_t *noise, size_t frames, int samplerate) {
+    const double freqs[] = {440.0, 1250.0, 3100.0};
+
+    for (size_t i = 0; i < frames; ++i) {
+        for (size_t k = 0; k < ARRAY_LEN(freqs); ++k) {
+            if (freqs[k] < samplerate / 2)
+                speech[i] += sin(2 * M_PI * freqs[k] * i / samplerate) / (k + 1);
+        }
+        noise[i] = bench_random();
+    }
+}
+
+/* voiced syllables in white noise with slowly varying amplitude */
+static void signal_am_noise(real_t *speech, real_t *noise, size_t frames, int samplerate) {
+    add_voice(speech, frames, samplerate, 140.0, 4.0, 0.0, 1.0);
+
+    for (size_t i = 0; i < frames; ++i)
+        noise[i] = bench_random() * (0.6 + 0.4 * sin(2 * M_PI * 0.5 * i / samplerate));
+}
+
+/* voiced syllables over babble of six other voices */
+static void signal_babble(real_t *speech, real_t *noise, size_t frames, int samplerate) {
+    add_voice(speech, frames, samplerate, 120.0, 4.0, 0.0, 1.0);
+
+    for (int v = 0; v < 6; ++v)
+        add_voice(noise, frames, samplerate, 175.0 + 75.0 * bench_random(), 4.5 + 1.5 * bench_random(),
+                  M_PI * bench_random(), 1.0);
+
+    for (size_t i = 0; i < frames; ++i)
+        noise[i] += 0.1 * bench_random();
+}
+
+/* add harmonic voice with fundamental f0, syllables of given rate modulate its amplitude */
+static void add_voice(real_t *data, size_t frames, int samplerate, double f0, double syllable_rate,
+                      double phase, double gain) {
+    double angle = phase;
+
+    for (size_t i = 0; i < frames; ++i) {
+        double t = (double) i / samplerate;
+        double envelope = sin(M_PI * syllable_rate * t + phase);
+        /* slow vibrato of fundamental, phase of fundamental is integrated */
+        double f = f0 * (1.0 + 0.03 * sin(2 * M_PI * 5.0 * t + phase));
+        double voice = 0;
+
+        angle += 2 * M_PI * f / samplerate;
+
+        for (int h = 1; h <= 12 && h * f < samplerate / 2; ++h)
+            voice += sin(h * angle) / h;
+
+        data[i] += gain * envelope * envelope * voice;
+    }
+}
+
+/* uniform pseudo random number in range <-1, 1) */
+static double bench_random(void) {
+    bench_seed = bench_seed * 1664525u + 1013904223u;
+    return bench_seed / 2147483648.0 - 1.0;
+}
+
+/* monotonic clock in seconds */
+static double bench_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* buffer of samples set to zero */
+static real_t *bench_buffer(size_t size) {
+    real_t *ptr = init_buffer_real(size);
+
+    if (ptr == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    return ptr;
+}
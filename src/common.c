@@ -21,58 +21,18 @@
 #include <math.h>
 
 #include "common.h"
+#include "simd.h"
 #include "i18n.h"
 
-/* sfx_mix_mono_read_double */
-sf_count_t sfx_mix_mono_read_double(SNDFILE *file, double *data, sf_count_t datalen) {
-    SF_INFO info;
-
-#if HAVE_SF_GET_INFO
-    /*
-    ** The function sf_get_info was in a number of 1.0.18 pre-releases but was removed
-    ** before 1.0.18 final and replaced with the SFC_GET_CURRENT_SF_INFO command.
-    */
-          sf_get_info (file, &info);
-#else
-    sf_command(file, SFC_GET_CURRENT_SF_INFO, &info, sizeof(info));
-#endif
-
-    if (info.channels == 1)
-        return sf_read_double(file, data, datalen);
-
-    static double multi_data[2048];
-    int frames_read;
-    sf_count_t dataout = 0;
-
-    while (dataout < datalen) {
-        int this_read;
-
-        this_read = MIN (ARRAY_LEN(multi_data) / info.channels, datalen);
-
-        frames_read = sf_readf_double(file, multi_data, this_read);
-        if (frames_read == 0)
-            break;
-
-        for (int k = 0; k < frames_read; ++k) {
-            double mix = 0.0;
-
-            for (int ch = 0; ch < info.channels; ++ch)
-                mix += multi_data[k * info.channels + ch];
-            data[dataout + k] = mix / info.channels;
-        };
-
-        dataout += this_read;
-    };
-
-    return dataout;
-}
+/* last bin of halfcomplex array with imaginary part, bins 1 ... last are complex */
+#define HC_LAST_COMPLEX(fft_size)           (((fft_size) - 1) / 2)
 
 /* separate_channels */
-int separate_channels_double(double *multi_data, double *single_data, int frames, int channels, int channel_number) {
+int separate_channels_real(real_t *multi_data, real_t *single_data, int frames, int channels, int channel_number) {
 
     if (channel_number > channels) {
         fprintf(stderr, _("This recording has only %u channels."), channels);
-        exit(1);
+        abort();
     }
 
     for (int k = 0; k < frames; ++k)
@@ -81,12 +41,12 @@ int separate_channels_double(double *multi_data, double *single_data, int frames
     return 0;
 }
 
-/* combine_channels_double */
-int combine_channels_double(double *multi_data, double *single_data, int frames, int channels, int channel_number) {
+/* combine_channels_real */
+int combine_channels_real(real_t *multi_data, real_t *single_data, int frames, int channels, int channel_number) {
 
     if (channel_number > channels) {
         fprintf(stderr, _("This recording has only %u channels."), channels);
-        exit(1);
+        abort();
     }
 
     for (int k = 0; k < frames; ++k)
@@ -95,13 +55,12 @@ int combine_channels_double(double *multi_data, double *single_data, int frames,
     return 0;
 }
 
-double *init_buffer_dbl(size_t size) {
-    double *ptr = (double *) malloc(sizeof(*ptr) * size);
+real_t *init_buffer_real(size_t size) {
+    real_t *ptr = (real_t *) malloc(sizeof(*ptr) * size);
+
+    if (ptr == NULL)
+        return NULL;
 
-    if (ptr == NULL) {
-        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
-        exit(1);
-    }
     /* initialize array to zero */
     memset((void *) ptr, 0, sizeof(*ptr) * size);
 
@@ -109,25 +68,38 @@ double *init_buffer_dbl(size_t size) {
 }
 
 /* multiply two arrays */
-void multiply_arrays_dbl(double *array1, double *array2, double *output_array, int len) {
+void multiply_arrays_real(real_t *array1, real_t *array2, real_t *output_array, int len) {
     for (int i = 0; i < len; ++i)
         output_array[i] = array1[i] * array2[i];
 }
 
 /* calc_magnitude */
-void calc_magnitude(const double *freq, size_t fft_size, double *magnitude) {
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        if (i == 0 || (i == fft_size / 2 && (fft_size % 2 == 0))) /* fft_size is even */
-            magnitude[i] = sqrt(freq[i] * freq[i]);
-        else
-            magnitude[i] = sqrt(freq[i] * freq[i] + freq[fft_size - i] * freq[fft_size - i]);
+void calc_magnitude(const real_t *freq, size_t fft_size, real_t *magnitude) {
+    size_t last = HC_LAST_COMPLEX(fft_size);
+    size_t i = 1;
+
+    /* DC and Nyquist (fft_size is even) bins have no imaginary part */
+    magnitude[0] = fabs(freq[0]);
+    if (fft_size % 2 == 0)
+        magnitude[fft_size / 2] = fabs(freq[fft_size / 2]);
+
+#ifdef SETK_SIMD_WIDTH
+    for (; i + SETK_SIMD_WIDTH - 1 <= last; i += SETK_SIMD_WIDTH) {
+        simd_real_t re = simd_load(freq + i);
+        simd_real_t im = simd_reverse(simd_load(freq + fft_size - i - (SETK_SIMD_WIDTH - 1)));
+
+        simd_store(magnitude + i, simd_sqrt(simd_add(simd_mul(re, re), simd_mul(im, im))));
     }
+#endif
+
+    for (; i <= last; ++i)
+        magnitude[i] = sqrt(freq[i] * freq[i] + freq[fft_size - i] * freq[fft_size - i]);
 
     return;
 }
 
 /* calc_phase */
-void calc_phase(const double *freq, size_t fft_size, double *phase) {
+void calc_phase(const real_t *freq, size_t fft_size, real_t *phase) {
     for (size_t i = 0; i <= fft_size / 2; ++i) {
         if (i == 0 || (i == fft_size / 2 && (fft_size % 2 == 0))) /* fft_size is even */
             phase[i] = complex_argument(freq[i], 0.0);
@@ -138,10 +110,25 @@ void calc_phase(const double *freq, size_t fft_size, double *phase) {
 }
 
 /* calc_power_spectrum */
-double calc_power_spectrum(const double *magnitude, size_t fft_size, double *power_spectrum) {
+double calc_power_spectrum(const real_t *magnitude, size_t fft_size, real_t *power_spectrum) {
+    size_t bins = fft_size / 2 + 1;
+    size_t i = 0;
     double norm_ps = 0;
 
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
+#ifdef SETK_SIMD_WIDTH
+    simd_real_t norm = simd_zero();
+
+    for (; i + SETK_SIMD_WIDTH <= bins; i += SETK_SIMD_WIDTH) {
+        simd_real_t mag = simd_load(magnitude + i);
+        simd_real_t ps = simd_mul(mag, mag);
+
+        simd_store(power_spectrum + i, ps);
+        norm = simd_add(norm, ps);
+    }
+    norm_ps = simd_hsum(norm);
+#endif
+
+    for (; i < bins; ++i) {
         power_spectrum[i] = magnitude[i] * magnitude[i];
         norm_ps += power_spectrum[i];
     }
@@ -150,29 +137,46 @@ double calc_power_spectrum(const double *magnitude, size_t fft_size, double *pow
 }
 
 /* calc_fft_complex_data */
-void calc_fft_complex_data(const double *magnitude, const double *phase, size_t fft_size, double *freq) {
-
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        if (i == 0 || (i == fft_size / 2 && (fft_size % 2 == 0))) /* fft_size is even */
-            freq[i] = magnitude[i];
-        else {
-            freq[i] = magnitude[i] * cos(phase[i]);
-            freq[fft_size - i] = magnitude[i] * sin(phase[i]);
-        }
+void calc_fft_complex_data(const real_t *magnitude, const real_t *phase, size_t fft_size, real_t *freq) {
+    size_t last = HC_LAST_COMPLEX(fft_size);
+
+    /* DC and Nyquist (fft_size is even) bins have no imaginary part */
+    freq[0] = magnitude[0];
+    if (fft_size % 2 == 0)
+        freq[fft_size / 2] = magnitude[fft_size / 2];
+
+    /* cos() and sin() dominate, there is nothing to gain from SIMD loads */
+    for (size_t i = 1; i <= last; ++i) {
+        freq[i] = magnitude[i] * cos(phase[i]);
+        freq[fft_size - i] = magnitude[i] * sin(phase[i]);
     }
 
     return;
 }
 
 /* multiply_fft_spec_with_gain */
-void multiply_fft_spec_with_gain(const double *gain, size_t fft_size, double *freq) {
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        if (i == 0 || (i == fft_size / 2 && (fft_size % 2 == 0))) /* fft_size is even */
-            freq[i] *= gain[i];
-        else {
-            freq[i] *= gain[i];
-            freq[fft_size - i] *= gain[i];
-        }
+void multiply_fft_spec_with_gain(const real_t *gain, size_t fft_size, real_t *freq) {
+    size_t last = HC_LAST_COMPLEX(fft_size);
+    size_t i = 1;
+
+    /* DC and Nyquist (fft_size is even) bins have no imaginary part */
+    freq[0] *= gain[0];
+    if (fft_size % 2 == 0)
+        freq[fft_size / 2] *= gain[fft_size / 2];
+
+#ifdef SETK_SIMD_WIDTH
+    for (; i + SETK_SIMD_WIDTH - 1 <= last; i += SETK_SIMD_WIDTH) {
+        real_t *imag = freq + fft_size - i - (SETK_SIMD_WIDTH - 1);
+        simd_real_t g = simd_load(gain + i);
+
+        simd_store(freq + i, simd_mul(simd_load(freq + i), g));
+        simd_store(imag, simd_mul(simd_load(imag), simd_reverse(g)));
+    }
+#endif
+
+    for (; i <= last; ++i) {
+        freq[i] *= gain[i];
+        freq[fft_size - i] *= gain[i];
     }
 
     return;
@@ -202,7 +206,7 @@ double check_nan(double number) {
 }
 
 char *show_time(int samplerate, int samples) {
-    static char time_buff[15];
+    static char time_buff[32];
     int hours, minutes;
     double seconds;
 
@@ -214,6 +218,6 @@ char *show_time(int samplerate, int samples) {
     hours = minutes / 60;
     minutes -= hours * 60;
 
-    sprintf(time_buff, "%02d:%02d:%06.3f", hours, minutes, seconds);
+    snprintf(time_buff, sizeof(time_buff), "%02d:%02d:%06.3f", hours, minutes, seconds);
     return time_buff;
 }
\ No newline at end of file
@@ -36,6 +36,20 @@
 /* Make sure it is an integer */
 #define WINDOW_SIZE(x, y)                   ((size_t) (floor(((x) * (y) / 1000))))
 
+/* sample type of processing pipeline, double is the reference precision
+ * and single precision is built with SETK_SINGLE_PRECISION defined */
+#ifdef SETK_SINGLE_PRECISION
+typedef float real_t;
+#define sf_read_real                        sf_read_float
+#define sf_readf_real                       sf_readf_float
+#define sf_writef_real                      sf_writef_float
+#else
+typedef double real_t;
+#define sf_read_real                        sf_read_double
+#define sf_readf_real                       sf_readf_double
+#define sf_writef_real                      sf_writef_double
+#endif
+
 #define ARRAY_LEN(x)                        ((int) (sizeof (x) / sizeof (x [0])))
 #define MAX(x, y)                           ((x) > (y) ? (x) : (y))
 #define MIN(x, y)                           ((x) < (y) ? (x) : (y))
@@ -60,37 +74,35 @@
 #define istrue_bool(x)                      ((((bool) (x)) == true) ? (_("enabled")) : (_("disabled")))
 #endif
 
-/* sfx_mix_mono_read_double */
-extern sf_count_t sfx_mix_mono_read_double(SNDFILE *file, double *data, sf_count_t datalen);
 
-/* separate_channels_double */
-extern int separate_channels_double(double *multi_data, double *single_data, int frames, int channels,
+/* separate_channels_real */
+extern int separate_channels_real(real_t *multi_data, real_t *single_data, int frames, int channels,
                                     int channel_number);
 
-/* combine_channels_double */
-extern int combine_channels_double(double *multi_data, double *single_data, int frames, int channels,
+/* combine_channels_real */
+extern int combine_channels_real(real_t *multi_data, real_t *single_data, int frames, int channels,
                                    int channel_number);
 
-/* create dynamic double array */
-extern double *init_buffer_dbl(size_t size);
+/* create dynamic array of samples set to zero, NULL when it cannot be allocated */
+extern real_t *init_buffer_real(size_t size);
 
 /* multiply two arrays */
-extern void multiply_arrays_dbl(double *array1, double *array2, double *output_array, int len);
+extern void multiply_arrays_real(real_t *array1, real_t *array2, real_t *output_array, int len);
 
 /* calc_magnitude */
-extern void calc_magnitude(const double *freq, size_t fft_size, double *magnitude);
+extern void calc_magnitude(const real_t *freq, size_t fft_size, real_t *magnitude);
 
 /* calc_phase */
-extern void calc_phase(const double *freq, size_t fft_size, double *phase);
+extern void calc_phase(const real_t *freq, size_t fft_size, real_t *phase);
 
 /* calc_power_spectrum */
-extern double calc_power_spectrum(const double *magnitude, size_t fft_size, double *power_spectrum);
+extern double calc_power_spectrum(const real_t *magnitude, size_t fft_size, real_t *power_spectrum);
 
 /* recreate complex array from magnitude and phase arrays */
-extern void calc_fft_complex_data(const double *magnitude, const double *phase, size_t fft_size, double *freq);
+extern void calc_fft_complex_data(const real_t *magnitude, const real_t *phase, size_t fft_size, real_t *freq);
 
 /* multiply_fft_spec_with_gain */
-extern void multiply_fft_spec_with_gain(const double *gain, size_t fft_size, double *freq);
+extern void multiply_fft_spec_with_gain(const real_t *gain, size_t fft_size, real_t *freq);
 
 /* phase of complex number */
 extern double complex_argument(const double real, const double imag);
@@ -0,0 +1,143 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "fft.h"
+
+#include "context.h"
+#include "i18n.h"
+
+/* create processing context */
+setk_context_t *setk_context_create(size_t fft_size, size_t window_size, int samplerate,
+                                    window_func_t window_function) {
+    /* buffers which are not allocated are NULL, so that partial context is destroyed */
+    setk_context_t *ctx = (setk_context_t *) calloc(1, sizeof(*ctx));
+    const window_table_t *table;
+    size_t bins = fft_size / 2 + 1;
+    int freq_res;
+
+    if (ctx == NULL)
+        return NULL;
+
+    ctx->fft_size = fft_size;
+    ctx->window_size = window_size;
+    ctx->samplerate = samplerate;
+    ctx->profile = NULL;
+
+    /* buffer is aligned for SIMD, so that plans may be shared with other contexts,
+     * window is calculated only once and shared by all contexts */
+    if ((ctx->fft_data = FFTW(alloc_real)(fft_size)) == NULL ||
+        (table = get_window_table(window_function, window_size)) == NULL) {
+        setk_context_destroy(ctx);
+        return NULL;
+    }
+    memset((void *) ctx->fft_data, 0, sizeof(*ctx->fft_data) * fft_size);
+
+    ctx->window = table->window;
+    ctx->win_gain = table->win_gain;
+
+    ctx->noise.P = init_buffer_real(bins);
+    ctx->noise.P_min = init_buffer_real(bins);
+    ctx->noise.P_tmp = init_buffer_real(bins);
+    ctx->noise.pk = init_buffer_real(bins);
+    ctx->noise.pxk_old = init_buffer_real(bins);
+    ctx->noise.pnk_old = init_buffer_real(bins);
+    ctx->noise.delta = init_buffer_real(bins);
+    ctx->noise.noise_ps_old = init_buffer_real(bins);
+
+    /* band limits are in bins, frequency resolution is rounded down to whole Hz */
+    freq_res = samplerate / (int) fft_size;
+    ctx->noise.k_1khz = (freq_res > 0) ? 1000 / freq_res : 0;
+    ctx->noise.k_3khz = (freq_res > 0) ? 3000 / freq_res : 0;
+
+    ctx->enh.Xk_prev = init_buffer_real(bins);
+    ctx->enh.G_prev = init_buffer_real(bins);
+    ctx->enh.posteri_prev = init_buffer_real(bins);
+
+    /* scratch is sized for the most demanding algorithm, so frames are processed without allocations */
+    if (arena_init(&ctx->scratch, SCRATCH_SPECTRA * ARENA_SIZE_REAL(bins) + ARENA_SIZE_REAL(fft_size) +
+                                  ARENA_SIZE_REAL(LPC_ORDER)) != 0 ||
+        ctx->noise.P == NULL || ctx->noise.P_min == NULL || ctx->noise.P_tmp == NULL || ctx->noise.pk == NULL ||
+        ctx->noise.pxk_old == NULL || ctx->noise.pnk_old == NULL || ctx->noise.delta == NULL ||
+        ctx->noise.noise_ps_old == NULL || ctx->enh.Xk_prev == NULL || ctx->enh.G_prev == NULL ||
+        ctx->enh.posteri_prev == NULL) {
+        setk_context_destroy(ctx);
+        return NULL;
+    }
+
+    setk_context_reset(ctx);
+
+    return ctx;
+}
+
+/* return context to its initial state */
+void setk_context_reset(setk_context_t *ctx) {
+    size_t len = sizeof(real_t) * (ctx->fft_size / 2 + 1);
+
+    memset((void *) ctx->noise.P, 0, len);
+    memset((void *) ctx->noise.P_min, 0, len);
+    memset((void *) ctx->noise.P_tmp, 0, len);
+    memset((void *) ctx->noise.pk, 0, len);
+    memset((void *) ctx->noise.pxk_old, 0, len);
+    memset((void *) ctx->noise.pnk_old, 0, len);
+    memset((void *) ctx->noise.delta, 0, len);
+    memset((void *) ctx->noise.noise_ps_old, 0, len);
+    ctx->noise.n = 0;
+    ctx->noise.window_offset = 0;
+
+    memset((void *) ctx->enh.Xk_prev, 0, len);
+    memset((void *) ctx->enh.G_prev, 0, len);
+    memset((void *) ctx->enh.posteri_prev, 0, len);
+    ctx->enh.SNRseg = 0.0;
+    ctx->enh.calls = 0;
+
+    ctx->snr_seg_sum = 0.0;
+    ctx->frames = 0;
+
+    ctx->track_noise_ps = NULL;
+    ctx->track_norm_ns_ps = 0.0;
+
+    arena_reset(&ctx->scratch);
+}
+
+/* free processing context */
+void setk_context_destroy(setk_context_t *ctx) {
+    if (ctx == NULL)
+        return;
+
+    FFTW(free)(ctx->fft_data);
+
+    free(ctx->noise.P);
+    free(ctx->noise.P_min);
+    free(ctx->noise.P_tmp);
+    free(ctx->noise.pk);
+    free(ctx->noise.pxk_old);
+    free(ctx->noise.pnk_old);
+    free(ctx->noise.delta);
+    free(ctx->noise.noise_ps_old);
+
+    free(ctx->enh.Xk_prev);
+    free(ctx->enh.G_prev);
+    free(ctx->enh.posteri_prev);
+
+    arena_free(&ctx->scratch);
+    profile_destroy(ctx->profile);
+
+    free(ctx);
+}
@@ -0,0 +1,79 @@
+/********************************************************************
+ function: Processing Context
+ contains: per-stream state of noise estimation, sound enhancement
+           and window function
+ ********************************************************************/
+
+#ifndef HAVE_CONTEXT_H
+#define HAVE_CONTEXT_H
+
+#include "common.h"
+#include "arena.h"
+#include "profile.h"
+#include "window.h"
+
+/* order of LPC analysis in iterative wiener filter */
+#define LPC_ORDER                           12
+
+/* most buffers of fft_size / 2 + 1 bins used by sound enhancement in one frame,
+ * besides them scratch holds one FFT buffer of fft_size and LPC buffers */
+#define SCRATCH_SPECTRA                     6
+
+/* frames of window of minimum search of mcra */
+#define MCRA_WINDOW                         100
+
+/* state of noise estimation algorithms, arrays hold fft_size / 2 + 1 bins */
+typedef struct noise_est_state_t {
+    real_t *P;
+    real_t *P_min;
+    real_t *P_tmp;
+    real_t *pk;
+    real_t *pxk_old;
+    real_t *pnk_old;
+    real_t *delta;
+    real_t *noise_ps_old;
+    int k_1khz;                             /* first bin of 1 - 3 kHz band used by mcra2 */
+    int k_3khz;
+    int n;                                  /* number of processed frames */
+    int window_offset;                      /* frames of current mcra window before the first frame,
+                                             * e.g. when segment starts in the middle of file */
+} noise_est_state_t;
+
+/* state of sound enhancement algorithms, arrays hold fft_size / 2 + 1 bins */
+typedef struct snd_enh_state_t {
+    double SNRseg;                          /* segmental SNR of previous frame */
+    real_t *Xk_prev;
+    real_t *G_prev;
+    real_t *posteri_prev;
+    int calls;                              /* number of processed frames */
+} snd_enh_state_t;
+
+/* processing context, one instance per processed channel */
+typedef struct setk_context_t {
+    size_t fft_size;
+    size_t window_size;
+    int samplerate;
+    real_t *fft_data;                       /* private FFT buffer, allocated by fftw_alloc_real() */
+    const real_t *window;                   /* shared window function table */
+    double win_gain;                        /* sum of window coefficients */
+    noise_est_state_t noise;
+    snd_enh_state_t enh;
+    setk_arena_t scratch;                   /* per-frame buffers, reset by sound enhancement */
+    setk_profile_t *profile;                /* stage timing of channel, NULL when profiling is off */
+    double snr_seg_sum;                     /* sum of segmental SNR of processed frames, for run statistics */
+    unsigned long frames;                   /* number of processed frames */
+    const real_t *track_noise_ps;           /* noise of frame from first pass of two-pass mode, or NULL */
+    double track_norm_ns_ps;                /* its sum, noise estimation is skipped when it is set */
+} setk_context_t;
+
+/* create processing context, NULL when its buffers cannot be allocated */
+extern setk_context_t *setk_context_create(size_t fft_size, size_t window_size, int samplerate,
+                                           window_func_t window_function);
+
+/* return context to its initial state, e.g. before processing next stream */
+extern void setk_context_reset(setk_context_t *ctx);
+
+/* free processing context */
+extern void setk_context_destroy(setk_context_t *ctx);
+
+#endif
@@ -0,0 +1,153 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "downmix.h"
+#include "simd.h"
+#include "i18n.h"
+
+/* parse comma separated weights of channels, returns number of weights or -1 */
+static int parse_weights(const char *str, real_t *weights, int channels);
+
+/* mix frames by SIMD kernel, returns number of mixed frames, the rest is mixed by scalar code */
+static size_t downmix_mix_simd(const setk_downmix_t *downmix, const real_t *multi_data, real_t *data,
+                               size_t frames);
+
+/* create downmix of channels */
+setk_status_t downmix_create(setk_downmix_t **downmix, int channels, const char *weights) {
+    setk_downmix_t *d = (setk_downmix_t *) calloc(1, sizeof(*d));
+
+    *downmix = NULL;
+    if (d == NULL || (d->weights = init_buffer_real((size_t) channels)) == NULL) {
+        downmix_destroy(d);
+        return SETK_ERROR_MEMORY;
+    }
+
+    d->channels = channels;
+
+    if (weights == NULL) {
+        for (int ch = 0; ch < channels; ++ch)
+            d->weights[ch] = (real_t) (1.0 / channels);
+    }
+    else if (parse_weights(weights, d->weights, channels) != channels) {
+        downmix_destroy(d);
+        return SETK_ERROR_DOWNMIX;
+    }
+
+#ifdef SETK_SIMD_WIDTH
+    /* sample i of k-th vector of one block belongs to channel (k * SETK_SIMD_WIDTH + i) % channels */
+    if ((d->sample_weights = init_buffer_real((size_t) channels * SETK_SIMD_WIDTH)) == NULL) {
+        downmix_destroy(d);
+        return SETK_ERROR_MEMORY;
+    }
+    for (int i = 0; i < channels * SETK_SIMD_WIDTH; ++i)
+        d->sample_weights[i] = d->weights[i % channels];
+#endif
+
+    *downmix = d;
+
+    return SETK_OK;
+}
+
+/* mix frames of interleaved multi_data into data */
+void downmix_mix(const setk_downmix_t *downmix, const real_t *multi_data, real_t *data, size_t frames) {
+    size_t k = downmix_mix_simd(downmix, multi_data, data, frames);
+    const real_t *w = downmix->weights;
+    int channels = downmix->channels;
+
+    for (; k < frames; ++k) {
+        const real_t *frame = multi_data + k * channels;
+        double mix = 0.0;
+
+        for (int ch = 0; ch < channels; ++ch)
+            mix += w[ch] * frame[ch];
+        data[k] = (real_t) mix;
+    }
+}
+
+/* free downmix */
+void downmix_destroy(setk_downmix_t *downmix) {
+    if (downmix == NULL)
+        return;
+
+    free(downmix->weights);
+    free(downmix->sample_weights);
+    free(downmix);
+}
+
+/* mix frames by SIMD kernel, one block of SETK_SIMD_WIDTH frames is loaded as channels vectors,
+ * every vector is multiplied by weights of its samples, log2(channels) levels of pairwise additions
+ * leave sums of frames of block in their order */
+static size_t downmix_mix_simd(const setk_downmix_t *downmix, const real_t *multi_data, real_t *data,
+                               size_t frames) {
+#ifdef SETK_SIMD_WIDTH
+    simd_real_t v[DOWNMIX_SIMD_CHANNELS_MAX];
+    int channels = downmix->channels;
+    size_t k = 0;
+
+    /* channels must be power of two, so pairs never span frames */
+    if (channels < 2 || channels > DOWNMIX_SIMD_CHANNELS_MAX || (channels & (channels - 1)) != 0)
+        return 0;
+
+    for (; k + SETK_SIMD_WIDTH <= frames; k += SETK_SIMD_WIDTH) {
+        const real_t *block = multi_data + k * channels;
+
+        for (int i = 0; i < channels; ++i)
+            v[i] = simd_mul(simd_load(block + i * SETK_SIMD_WIDTH),
+                            simd_load(downmix->sample_weights + i * SETK_SIMD_WIDTH));
+
+        for (int n = channels; n > 1; n /= 2) {
+            for (int i = 0; i < n / 2; ++i)
+                v[i] = simd_pairwise_add(v[2 * i], v[2 * i + 1]);
+        }
+
+        simd_store(data + k, v[0]);
+    }
+
+    return k;
+#else
+    return 0;
+#endif
+}
+
+/* parse comma separated weights of channels, every weight must be finite number */
+static int parse_weights(const char *str, real_t *weights, int channels) {
+    const char *p = str;
+    char *end;
+    int count = 0;
+    double w;
+
+    while (*p != '\0') {
+        errno = 0;
+        w = strtod(p, &end);
+        if (end == p || errno != 0 || !isfinite(w) || count == channels)
+            return -1;
+
+        weights[count++] = (real_t) w;
+        p = end;
+        if (*p == ',')
+            p++;
+        else if (*p != '\0')
+            return -1;
+    }
+
+    return count;
+}
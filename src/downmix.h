@@ -0,0 +1,34 @@
+/********************************************************************
+ function: Downmix
+ contains: mixing of interleaved channels to mono with weights of
+           channels, blocks are mixed with SIMD for 2, 4 and 8 channels
+ ********************************************************************/
+
+#ifndef HAVE_DOWNMIX_H
+#define HAVE_DOWNMIX_H
+
+#include "setk.h"
+#include "common.h"
+
+/* channels mixed by SIMD kernel, which reduces them by tree of pairwise additions */
+#define DOWNMIX_SIMD_CHANNELS_MAX           8
+
+/* downmix of one input, every input has its own, so inputs may be read by parallel threads */
+typedef struct setk_downmix_t {
+    int channels;                           /* channels of input */
+    real_t *weights;                        /* weight of every channel */
+    real_t *sample_weights;                 /* weights of channels of consecutive SIMD vectors of samples */
+} setk_downmix_t;
+
+/* create downmix of channels, weights is comma separated list of weight of every channel, e.g. "0.7,0.3",
+ * channel of weight 0 is left out, NULL mixes mean of channels, returns SETK_ERROR_DOWNMIX when weights
+ * are not valid, *downmix is NULL on error */
+extern setk_status_t downmix_create(setk_downmix_t **downmix, int channels, const char *weights);
+
+/* mix frames of interleaved multi_data into data */
+extern void downmix_mix(const setk_downmix_t *downmix, const real_t *multi_data, real_t *data, size_t frames);
+
+/* free downmix */
+extern void downmix_destroy(setk_downmix_t *downmix);
+
+#endif
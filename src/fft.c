@@ -0,0 +1,190 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "fft.h"
+#include "i18n.h"
+
+/* FFTW planner is not thread safe, all planning is serialized by this lock */
+static pthread_mutex_t plans_lock = PTHREAD_MUTEX_INITIALIZER;
+static fft_plans_t *plans_list = NULL;
+static unsigned plan_flags = FFTW_MEASURE;
+static bool wisdom_changed = false;        /* plans were measured, wisdom is worth saving */
+
+/* create plan, wisdom is used if available, called with plans_lock held */
+static fft_plan_t create_plan(size_t fft_size, real_t *plan_data, fftw_r2r_kind kind);
+
+/* parse planning effort */
+int fft_parse_plan_effort(const char *name, unsigned *flags) {
+    if (strcmp(name, "estimate") == 0)
+        *flags = FFTW_ESTIMATE;
+    else if (strcmp(name, "measure") == 0)
+        *flags = FFTW_MEASURE;
+    else if (strcmp(name, "patient") == 0)
+        *flags = FFTW_PATIENT;
+    else
+        return 1;
+
+    return 0;
+}
+
+/* set FFTW planner flags used for new plans */
+void fft_set_plan_flags(unsigned flags) {
+    pthread_mutex_lock(&plans_lock);
+    plan_flags = flags;
+    pthread_mutex_unlock(&plans_lock);
+}
+
+/* import FFTW wisdom from cache file */
+int fft_wisdom_import(const char *filename) {
+    int status;
+
+    pthread_mutex_lock(&plans_lock);
+    status = FFTW(import_wisdom_from_filename)(filename) ? 0 : 1;
+    pthread_mutex_unlock(&plans_lock);
+
+    return status;
+}
+
+/* export FFTW wisdom into cache file */
+int fft_wisdom_export(const char *filename) {
+    char *tmp_name;
+    int status = 0;
+
+    pthread_mutex_lock(&plans_lock);
+
+    if (!wisdom_changed) {
+        pthread_mutex_unlock(&plans_lock);
+        return 0;
+    }
+
+    /* file is replaced atomically, other processes may be reading it */
+    if ((tmp_name = (char *) malloc(strlen(filename) + 32)) == NULL) {
+        printf(_("Error: Unable to write FFTW wisdom '%s': %s\n"), filename, strerror(errno));
+        pthread_mutex_unlock(&plans_lock);
+        return 1;
+    }
+    sprintf(tmp_name, "%s.%ld.tmp", filename, (long) getpid());
+
+    if (!FFTW(export_wisdom_to_filename)(tmp_name) || rename(tmp_name, filename) != 0) {
+        printf(_("Error: Unable to write FFTW wisdom '%s': %s\n"), filename, strerror(errno));
+        unlink(tmp_name);
+        status = 1;
+    }
+    else {
+        wisdom_changed = false;
+    }
+
+    free(tmp_name);
+    pthread_mutex_unlock(&plans_lock);
+
+    return status;
+}
+
+/* create plans for every reachable FFT size */
+void fft_plans_prewarm(size_t fft_size) {
+    /* OPTIMAL_FFT_SIZE is always a power of two */
+    for (size_t size = 2; size <= FFT_MAX; size *= 2)
+        fft_plans_get(size);
+
+    if (fft_size != 0)
+        fft_plans_get(fft_size);
+}
+
+/* get plans for fft_size */
+const fft_plans_t *fft_plans_get(size_t fft_size) {
+    fft_plans_t *plans;
+    real_t *plan_data;
+
+    pthread_mutex_lock(&plans_lock);
+
+    for (plans = plans_list; plans != NULL; plans = plans->next) {
+        if (plans->fft_size == fft_size) {
+            pthread_mutex_unlock(&plans_lock);
+            return plans;
+        }
+    }
+
+    /* measuring planners overwrite the buffer, so plans are made on a scratch one */
+    if ((plans = (fft_plans_t *) malloc(sizeof(*plans))) == NULL ||
+        (plan_data = FFTW(alloc_real)(fft_size)) == NULL) {
+        free(plans);
+        pthread_mutex_unlock(&plans_lock);
+        return NULL;
+    }
+
+    plans->fft_size = fft_size;
+    plans->fft_forw = create_plan(fft_size, plan_data, FFTW_R2HC);
+    plans->fft_back = create_plan(fft_size, plan_data, FFTW_HC2R);
+    FFTW(free)(plan_data);
+
+    /* planner returns NULL when it cannot plan the transform */
+    if (plans->fft_forw == NULL || plans->fft_back == NULL) {
+        if (plans->fft_forw != NULL)
+            FFTW(destroy_plan)(plans->fft_forw);
+        if (plans->fft_back != NULL)
+            FFTW(destroy_plan)(plans->fft_back);
+        free(plans);
+        pthread_mutex_unlock(&plans_lock);
+        return NULL;
+    }
+
+    plans->next = plans_list;
+    plans_list = plans;
+
+    pthread_mutex_unlock(&plans_lock);
+
+    return plans;
+}
+
+/* destroy all cached plans */
+void fft_plans_cleanup(void) {
+    fft_plans_t *plans;
+
+    pthread_mutex_lock(&plans_lock);
+
+    while ((plans = plans_list) != NULL) {
+        plans_list = plans->next;
+        FFTW(destroy_plan)(plans->fft_forw);
+        FFTW(destroy_plan)(plans->fft_back);
+        free(plans);
+    }
+
+    pthread_mutex_unlock(&plans_lock);
+}
+
+/* create plan, wisdom is used if available, called with plans_lock held */
+static fft_plan_t create_plan(size_t fft_size, real_t *plan_data, fftw_r2r_kind kind) {
+    fft_plan_t plan;
+
+    if (plan_flags == FFTW_ESTIMATE)
+        return FFTW(plan_r2r_1d)((int) fft_size, plan_data, plan_data, kind, plan_flags);
+
+    if ((plan = FFTW(plan_r2r_1d)((int) fft_size, plan_data, plan_data, kind, plan_flags | FFTW_WISDOM_ONLY)) != NULL)
+        return plan;
+
+    /* plan had to be measured, new wisdom should be saved */
+    wisdom_changed = true;
+
+    return FFTW(plan_r2r_1d)((int) fft_size, plan_data, plan_data, kind, plan_flags);
+}
@@ -0,0 +1,52 @@
+/********************************************************************
+ function: FFT Plans
+ contains: process-wide cache of FFTW plans keyed by FFT size
+ ********************************************************************/
+
+#ifndef HAVE_FFT_H
+#define HAVE_FFT_H
+
+#include <fftw3.h>
+#include "common.h"
+
+/* FFTW interface of precision selected by real_t, e.g. FFTW(execute_r2r) */
+#ifdef SETK_SINGLE_PRECISION
+#define FFTW(name)                          fftwf_##name
+#else
+#define FFTW(name)                          fftw_##name
+#endif
+
+typedef FFTW(plan) fft_plan_t;
+
+/* forward and backward real-to-halfcomplex plans of one FFT size */
+typedef struct fft_plans_t {
+    size_t fft_size;
+    fft_plan_t fft_forw;
+    fft_plan_t fft_back;
+    struct fft_plans_t *next;
+} fft_plans_t;
+
+/* parse planning effort: estimate, measure or patient, returns 1 if name is unknown */
+extern int fft_parse_plan_effort(const char *name, unsigned *flags);
+
+/* set FFTW planner flags used for new plans, default is FFTW_MEASURE */
+extern void fft_set_plan_flags(unsigned flags);
+
+/* import FFTW wisdom from cache file, returns 0 if wisdom was loaded */
+extern int fft_wisdom_import(const char *filename);
+
+/* export FFTW wisdom into cache file if new plans were measured since import, returns 0 on success */
+extern int fft_wisdom_export(const char *filename);
+
+/* create plans for every FFT size reachable from OPTIMAL_FFT_SIZE and for fft_size, if non zero */
+extern void fft_plans_prewarm(size_t fft_size);
+
+/* get plans for fft_size, they are created on first use and may be
+ * executed from any thread with FFTW(execute_r2r) on buffers from FFTW(alloc_real),
+ * NULL when they cannot be allocated */
+extern const fft_plans_t *fft_plans_get(size_t fft_size);
+
+/* destroy all cached plans */
+extern void fft_plans_cleanup(void);
+
+#endif
@@ -0,0 +1,321 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "framer.h"
+#include "i18n.h"
+
+/* read frames until count is reached or input ends */
+static sf_count_t framer_read_frames(setk_framer_t *framer, real_t *data, sf_count_t frames, bool *eof,
+                                     bool *failed);
+
+/* read interleaved frames of input */
+static sf_count_t framer_read_input(const framer_io_t *io, real_t *data, sf_count_t frames);
+
+/* write frames to output file */
+static sf_count_t framer_write_frames(setk_framer_t *framer, const real_t *data, sf_count_t frames);
+
+/* start reader and writer threads, returns 0 on success */
+static int framer_start(setk_framer_t *framer);
+
+/* let writer thread write queued output and join both I/O threads */
+static void framer_stop(setk_framer_t *framer);
+
+/* reader thread, decodes blocks of input ahead of framer */
+static void *framer_reader(void *arg);
+
+/* writer thread, encodes blocks of output behind framer */
+static void *framer_writer(void *arg);
+
+/* create framer */
+setk_framer_t *framer_create(const framer_io_t *io, int input_channels, int output_channels, bool async,
+                             setk_profile_t *profile) {
+    setk_framer_t *framer = (setk_framer_t *) calloc(1, sizeof(*framer));
+
+    if (framer == NULL)
+        return NULL;
+
+    framer->io = *io;
+    framer->input_channels = input_channels;
+    framer->output_channels = output_channels;
+    framer->async = async;
+    framer->profile = profile;
+
+    /* I/O threads have blocks of their own */
+    if (async) {
+        if (framer_start(framer) != 0) {
+            framer_destroy(framer);
+            return NULL;
+        }
+    }
+    else {
+        framer->input = init_buffer_real((size_t) FRAMER_BLOCK_FRAMES * input_channels);
+        framer->output = init_buffer_real((size_t) FRAMER_BLOCK_FRAMES * output_channels);
+        if (framer->input == NULL || framer->output == NULL) {
+            framer_destroy(framer);
+            return NULL;
+        }
+    }
+
+    return framer;
+}
+
+/* next block of input, in async mode block of previous read is given back to reader thread */
+sf_count_t framer_read(setk_framer_t *framer, const real_t **data) {
+    sf_count_t count = 0;
+    uint64_t t = PROFILE_BEGIN(framer->profile);
+    framer_block_t *block;
+
+    if (framer->read_block != NULL) {
+        queue_push(&framer->read_free, framer->read_block);
+        framer->read_block = NULL;
+    }
+
+    /* input is not read after output failed */
+    if (framer->eof || framer->write_failed)
+        ;
+    else if (!framer->async) {
+        count = framer_read_frames(framer, framer->input, FRAMER_BLOCK_FRAMES, &framer->eof, &framer->read_failed);
+        *data = framer->input;
+    }
+    else if ((block = (framer_block_t *) queue_pop(&framer->read_full)) != NULL) {
+        /* reader thread fills whole blocks, only the last one is shorter */
+        count = block->frames;
+        framer->eof = block->eof;
+        framer->read_failed = block->failed;
+        framer->read_block = block;
+        *data = block->data;
+    }
+    else
+        framer->eof = true;
+
+    framer->frames_read += count;
+
+    PROFILE_END(framer->profile, PROFILE_READ, t);
+
+    return count;
+}
+
+/* buffer for block of output, in async mode it is free block of writer thread */
+real_t *framer_output(setk_framer_t *framer) {
+    if (framer->write_failed)
+        return NULL;
+
+    if (!framer->async)
+        return framer->output;
+
+    /* writer thread closes queue of free blocks when it fails */
+    if (framer->write_block == NULL &&
+        (framer->write_block = (framer_block_t *) queue_pop(&framer->write_free)) == NULL) {
+        framer->write_failed = true;
+        return NULL;
+    }
+
+    return framer->write_block->data;
+}
+
+/* write frames of output buffer, in async mode it is handed over to writer thread */
+int framer_write(setk_framer_t *framer, sf_count_t frames) {
+    uint64_t t = PROFILE_BEGIN(framer->profile);
+
+    if (framer->write_failed || (framer->async && framer->write_block == NULL))
+        return 1;
+
+    if (!framer->async) {
+        if (framer_write_frames(framer, framer->output, frames) != frames)
+            framer->write_failed = true;
+        else
+            framer->frames_written += frames;
+    }
+    else {
+        framer->write_block->frames = frames;
+        queue_push(&framer->write_full, framer->write_block);
+        framer->write_block = NULL;
+    }
+
+    PROFILE_END(framer->profile, PROFILE_WRITE, t);
+
+    return framer->write_failed ? 1 : 0;
+}
+
+/* wait until all output is written and join I/O threads */
+void framer_finish(setk_framer_t *framer) {
+    framer_stop(framer);
+}
+
+/* free framer */
+void framer_destroy(setk_framer_t *framer) {
+    if (framer == NULL)
+        return;
+
+    if (framer->async) {
+        framer_stop(framer);
+
+        queue_destroy(&framer->read_free);
+        queue_destroy(&framer->read_full);
+        queue_destroy(&framer->write_free);
+        queue_destroy(&framer->write_full);
+
+        for (int i = 0; i < FRAMER_QUEUE_BLOCKS; ++i) {
+            free(framer->read_blocks[i].data);
+            free(framer->write_blocks[i].data);
+        }
+    }
+
+    free(framer->input);
+    free(framer->output);
+    free(framer);
+}
+
+/* read frames until count is reached or input ends, reads of streams may return fewer frames,
+ * mapped input is converted straight into data */
+static sf_count_t framer_read_frames(setk_framer_t *framer, real_t *data, sf_count_t frames, bool *eof,
+                                     bool *failed) {
+    const framer_io_t *io = &framer->io;
+    sf_count_t count, total = 0;
+
+    while (total < frames) {
+        count = framer_read_input(io, data + total * framer->input_channels, frames - total);
+
+        if (count <= 0) {
+            *eof = true;
+            *failed = (io->mapped_input == NULL && sf_error(io->input) != SF_ERR_NO_ERROR);
+            break;
+        }
+        total += count;
+    }
+
+    return total;
+}
+
+/* read interleaved frames of input, returns number of frames, 0 at end of input */
+static sf_count_t framer_read_input(const framer_io_t *io, real_t *data, sf_count_t frames) {
+    if (io->mapped_input != NULL)
+        return mapped_read(io->mapped_input, data, frames);
+
+    return sf_readf_real(io->input, data, frames);
+}
+
+/* write frames, mapped output is converted straight from data, returns number of written frames */
+static sf_count_t framer_write_frames(setk_framer_t *framer, const real_t *data, sf_count_t frames) {
+    if (framer->io.mapped_output != NULL)
+        return mapped_write(framer->io.mapped_output, data, frames);
+
+    return sf_writef_real(framer->io.output, data, frames);
+}
+
+/* start reader and writer threads, all blocks are free, queues and blocks are freed by framer_destroy()
+ * when it fails */
+static int framer_start(setk_framer_t *framer) {
+    int status = 0;
+
+    status |= queue_init(&framer->read_free, FRAMER_QUEUE_BLOCKS);
+    status |= queue_init(&framer->read_full, FRAMER_QUEUE_BLOCKS);
+    status |= queue_init(&framer->write_free, FRAMER_QUEUE_BLOCKS);
+    status |= queue_init(&framer->write_full, FRAMER_QUEUE_BLOCKS);
+    if (status != 0)
+        return 1;
+
+    for (int i = 0; i < FRAMER_QUEUE_BLOCKS; ++i) {
+        framer->read_blocks[i].data = init_buffer_real((size_t) FRAMER_BLOCK_FRAMES * framer->input_channels);
+        framer->write_blocks[i].data = init_buffer_real((size_t) FRAMER_BLOCK_FRAMES * framer->output_channels);
+        if (framer->read_blocks[i].data == NULL || framer->write_blocks[i].data == NULL)
+            return 1;
+
+        queue_push(&framer->read_free, &framer->read_blocks[i]);
+        queue_push(&framer->write_free, &framer->write_blocks[i]);
+    }
+
+    if (pthread_create(&framer->reader, NULL, framer_reader, framer) != 0)
+        return 1;
+
+    /* reader stops at its next block once its queues are closed */
+    if (pthread_create(&framer->writer, NULL, framer_writer, framer) != 0) {
+        queue_close(&framer->read_free);
+        queue_close(&framer->read_full);
+        pthread_join(framer->reader, NULL);
+        return 1;
+    }
+    framer->running = true;
+
+    return 0;
+}
+
+/* let writer thread write queued output and join both I/O threads, reader is stopped at its next block */
+static void framer_stop(setk_framer_t *framer) {
+    void *failed;
+
+    if (!framer->running)
+        return;
+
+    queue_close(&framer->write_full);
+    pthread_join(framer->writer, &failed);
+    if (failed != NULL)
+        framer->write_failed = true;
+
+    queue_close(&framer->read_free);
+    queue_close(&framer->read_full);
+    pthread_join(framer->reader, NULL);
+
+    framer->running = false;
+}
+
+/* reader thread, decodes blocks of input ahead of framer, exits after end of input */
+static void *framer_reader(void *arg) {
+    setk_framer_t *framer = (setk_framer_t *) arg;
+    framer_block_t *block;
+    bool eof = false;
+
+    while (!eof && (block = (framer_block_t *) queue_pop(&framer->read_free)) != NULL) {
+        block->eof = false;
+        block->failed = false;
+        block->frames = framer_read_frames(framer, block->data, FRAMER_BLOCK_FRAMES, &block->eof, &block->failed);
+        eof = block->eof;
+
+        if (queue_push(&framer->read_full, block) != 0)
+            break;
+    }
+
+    return NULL;
+}
+
+/* writer thread, encodes blocks of output until framer stops, failure is reported to framer by closing
+ * queue of free blocks and to framer_stop() by return value */
+static void *framer_writer(void *arg) {
+    setk_framer_t *framer = (setk_framer_t *) arg;
+    framer_block_t *block;
+    bool failed = false;
+
+    while ((block = (framer_block_t *) queue_pop(&framer->write_full)) != NULL) {
+        if (failed)
+            continue;
+
+        if (framer_write_frames(framer, block->data, block->frames) != block->frames) {
+            failed = true;
+            queue_close(&framer->write_free);
+        }
+        else {
+            framer->frames_written += block->frames;
+            queue_push(&framer->write_free, block);
+        }
+    }
+
+    return failed ? framer : NULL;
+}
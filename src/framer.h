@@ -0,0 +1,92 @@
+/********************************************************************
+ function: Framing of audio streams
+ contains: input is read in large blocks, which are pushed to libsetk
+           stream, and its output is written back in blocks,
+           optionally by reader and writer threads, mapped files are
+           used instead of libsndfile
+ ********************************************************************/
+
+#ifndef HAVE_FRAMER_H
+#define HAVE_FRAMER_H
+
+#include <pthread.h>
+#include "common.h"
+#include "profile.h"
+#include "queue.h"
+#include "mapped.h"
+
+/* frames read from input at once, libsndfile is called once per block instead of once per hop */
+#define FRAMER_BLOCK_FRAMES                 65536
+
+/* blocks in flight between framer and each of its I/O threads */
+#define FRAMER_QUEUE_BLOCKS                 4
+
+/* input and output of framer, mapped files are used instead of libsndfile when they are not NULL */
+typedef struct framer_io_t {
+    SNDFILE *input;
+    setk_mapped_t *mapped_input;
+    SNDFILE *output;
+    setk_mapped_t *mapped_output;
+} framer_io_t;
+
+/* block of frames passed between framer and reader or writer thread */
+typedef struct framer_block_t {
+    real_t *data;
+    sf_count_t frames;
+    bool eof;                               /* input ended in this block */
+    bool failed;                            /* reading failed, input ended as well */
+} framer_block_t;
+
+/* framer of one input and output file, blocks of input are read into input buffer or by reader thread,
+ * output is collected in output block, which is written or handed over to writer thread */
+typedef struct setk_framer_t {
+    framer_io_t io;
+    int input_channels;
+    int output_channels;
+    real_t *input;                          /* block of input, sync mode */
+    real_t *output;                         /* block of output, sync mode */
+    sf_count_t frames_read;                 /* frames read from input */
+    sf_count_t frames_written;              /* frames written to output, by writer thread in async mode */
+    bool eof;
+    bool read_failed;
+    bool write_failed;
+    setk_profile_t *profile;                /* timing of reads and writes, NULL when profiling is off */
+
+    /* async mode, decoding and encoding run on reader and writer threads, which exchange blocks
+     * with framer through queues, queues of free blocks give back-pressure */
+    bool async;
+    bool running;                           /* I/O threads were started and not joined yet */
+    pthread_t reader;
+    pthread_t writer;
+    framer_block_t *read_block;             /* block returned by last read, it is freed by next read */
+    framer_block_t *write_block;            /* block of output which is being filled */
+    framer_block_t read_blocks[FRAMER_QUEUE_BLOCKS];
+    framer_block_t write_blocks[FRAMER_QUEUE_BLOCKS];
+    setk_queue_t read_free;
+    setk_queue_t read_full;
+    setk_queue_t write_free;
+    setk_queue_t write_full;
+} setk_framer_t;
+
+/* create framer of input and output channels, in async mode input and output files are only used
+ * by I/O threads until framer_finish(), NULL when its buffers or threads cannot be created */
+extern setk_framer_t *framer_create(const framer_io_t *io, int input_channels, int output_channels, bool async,
+                                    setk_profile_t *profile);
+
+/* next block of at most FRAMER_BLOCK_FRAMES interleaved input frames, data is valid until next read,
+ * returns number of its frames, 0 at end of input or when reading failed */
+extern sf_count_t framer_read(setk_framer_t *framer, const real_t **data);
+
+/* buffer for FRAMER_BLOCK_FRAMES interleaved output frames, NULL after writing failed */
+extern real_t *framer_output(setk_framer_t *framer);
+
+/* write frames of output buffer, returns 0 on success */
+extern int framer_write(setk_framer_t *framer, sf_count_t frames);
+
+/* wait until all output is written and join I/O threads */
+extern void framer_finish(setk_framer_t *framer);
+
+/* free framer, files are neither closed nor unmapped */
+extern void framer_destroy(setk_framer_t *framer);
+
+#endif
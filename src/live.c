@@ -0,0 +1,285 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include <pulse/simple.h>
+#include <pulse/error.h>
+
+#include "config.h"
+#include "live.h"
+#include "stream.h"
+#include "i18n.h"
+
+/* set by SIGINT, live loop stops after current hop */
+static volatile sig_atomic_t live_stop = 0;
+
+/* SIGINT handler */
+static void live_interrupt(int sig);
+
+/* monotonic clock in microseconds */
+static double live_clock(void);
+
+/* open PulseAudio stream, device NULL is the default one */
+static pa_simple *live_open(pa_stream_direction_t direction, const char *device, const pa_sample_spec *spec,
+                            const pa_buffer_attr *attr);
+
+/* print statistics of live stream */
+static void live_report(const live_stats_t *stats, int nslide, int window_size, int samplerate);
+
+/* capture, enhance and play back */
+int process_live(const setk_options_t *opts) {
+    /* window and fft size are computed on a copy of options, like for every file */
+    setk_options_t live_opts = *opts;
+    setk_options_t *args = &live_opts;
+
+    /* initialize variables */
+    pa_sample_spec spec;
+    pa_buffer_attr capture_attr, playback_attr;
+    pa_simple *capture, *playback;
+    pa_usec_t capture_latency, playback_latency = 0;
+    setk_stream_options_t stream_opts;
+    setk_stream_t *stream;
+    setk_status_t stream_status;
+    live_stats_t stats;
+    struct sigaction action, old_action;
+    float *pcm;
+    real_t *in, *out;
+    size_t hop_bytes;
+    int nslide, frames_in, error;
+    int window_size;
+    int channels = args->live_channels;
+    int samplerate = args->live_samplerate;
+    double hop_usec, frame_usec, read_done, process_done, last_write = 0, latency;
+    int status = 0;
+
+    compute_frame_size(args, samplerate);
+
+    spec.format = PA_SAMPLE_FLOAT32NE;
+    spec.rate = (uint32_t) samplerate;
+    spec.channels = (uint8_t) channels;
+
+    if (!pa_sample_spec_valid(&spec)) {
+        printf(_("Error: PulseAudio does not support %d Hz with %d channels.\n"), samplerate, channels);
+        return 1;
+    }
+
+    /* capture is played back, so its channels are not mixed, capture is enhanced from the first hop,
+     * noise estimation starts from loaded profile */
+    stream_options(args, &stream_opts);
+    stream_opts.downmix = false;
+    stream_opts.downmix_weights = NULL;
+    if ((stream_status = stream_create(&stream, samplerate, channels, &stream_opts, args->noise_profile)) != SETK_OK) {
+        stream_error(args, stream_status, samplerate, channels);
+        return 1;
+    }
+
+    window_size = (int) setk_stream_window_size(stream);
+    nslide = (int) setk_stream_hop_size(stream);
+
+    hop_bytes = nslide * pa_frame_size(&spec);
+    hop_usec = 1e6 * nslide / samplerate;
+    frame_usec = 1e6 * window_size / samplerate;
+
+    /* capture is read in fragments of one hop, its buffer is bounded, so input lost by server is detected */
+    capture_attr.maxlength = (uint32_t) (LIVE_CAPTURE_HOPS * hop_bytes);
+    capture_attr.fragsize = (uint32_t) hop_bytes;
+    capture_attr.tlength = capture_attr.prebuf = capture_attr.minreq = (uint32_t) -1;
+
+    /* playback queue is kept short, write of a hop blocks until server requests data */
+    playback_attr.maxlength = (uint32_t) -1;
+    playback_attr.tlength = (uint32_t) (LIVE_PLAYBACK_HOPS * hop_bytes);
+    playback_attr.prebuf = (uint32_t) -1;
+    playback_attr.minreq = (uint32_t) hop_bytes;
+    playback_attr.fragsize = (uint32_t) -1;
+
+    if ((capture = live_open(PA_STREAM_RECORD, args->live_source, &spec, &capture_attr)) == NULL) {
+        setk_stream_destroy(stream);
+        return 1;
+    }
+
+    if ((playback = live_open(PA_STREAM_PLAYBACK, args->live_sink, &spec, &playback_attr)) == NULL) {
+        pa_simple_free(capture);
+        setk_stream_destroy(stream);
+        return 1;
+    }
+
+    pcm = (float *) malloc(sizeof(*pcm) * window_size * channels);
+    in = init_buffer_real((size_t) window_size * channels);
+    out = init_buffer_real((size_t) nslide * channels);
+    if (pcm == NULL || in == NULL || out == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    /* stream selects the same algorithms, defaults are only reported here */
+    parse_window_type(args->window_type, args->verbosity);
+    parse_snd_enhance_type(args->snd_enhance_type, args->verbosity);
+    parse_noise_est_type(args->noise_est_type, args->verbosity);
+
+    if (args->verbosity) {
+        printf(_("Live mode: %d Hz, %d channels, frame %.1f ms, hop %.1f ms\n"), samplerate, channels,
+               frame_usec / 1000, hop_usec / 1000);
+        printf(_("Press Ctrl+C to stop.\n"));
+    }
+
+    /* Ctrl+C stops capture, playback is drained before exit */
+    memset((void *) &action, 0, sizeof(action));
+    action.sa_handler = live_interrupt;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, &old_action);
+    live_stop = 0;
+
+    memset((void *) &stats, 0, sizeof(stats));
+
+    /* first push holds window_size new frames, every next one nslide, so every push enhances one frame */
+    frames_in = window_size;
+
+    while (!live_stop) {
+        if (pa_simple_read(capture, pcm, sizeof(*pcm) * frames_in * channels, &error) < 0) {
+            printf(_("Error: Unable to read from PulseAudio: %s\n"), pa_strerror(error));
+            status = 1;
+            break;
+        }
+        read_done = live_clock();
+
+        /* backlog left in capture buffer, once it fills the buffer, server drops input */
+        capture_latency = pa_simple_get_latency(capture, &error);
+        if (capture_latency + hop_usec >= LIVE_CAPTURE_HOPS * hop_usec)
+            stats.overruns++;
+
+        for (int i = 0; i < frames_in * channels; ++i)
+            in[i] = pcm[i];
+
+        if ((stream_status = setk_stream_push(stream, in, (size_t) frames_in)) != SETK_OK) {
+            printf(_("Error: %s.\n"), setk_strerror(stream_status));
+            status = 1;
+            break;
+        }
+        setk_stream_pull(stream, out, (size_t) nslide);
+
+        for (int i = 0; i < nslide * channels; ++i)
+            pcm[i] = (float) out[i];
+
+        process_done = live_clock();
+        if (process_done - read_done > hop_usec)
+            stats.late_hops++;
+        stats.process_max = MAX(stats.process_max, process_done - read_done);
+
+        /* audio queued by previous write was played before this one, so playback buffer ran empty */
+        if (stats.hops > 0 && process_done - last_write > playback_latency)
+            stats.underruns++;
+
+        if (pa_simple_write(playback, pcm, hop_bytes, &error) < 0) {
+            printf(_("Error: Unable to write to PulseAudio: %s\n"), pa_strerror(error));
+            status = 1;
+            break;
+        }
+        last_write = live_clock();
+        playback_latency = pa_simple_get_latency(playback, &error);
+
+        /* newest input sample of frame waited in capture buffer, then for the whole frame, last output
+         * sample of hop waits for processing and playback queue */
+        latency = capture_latency + frame_usec + (process_done - read_done) + playback_latency;
+        stats.latency_sum += latency;
+        stats.latency_max = MAX(stats.latency_max, latency);
+        stats.hops++;
+
+        if (args->verbosity) {
+            printf(_("%s  latency %6.1f ms  overruns %lu  underruns %lu\r"),
+                   show_time(samplerate, (int) (stats.hops * nslide)), latency / 1000, stats.overruns,
+                   stats.underruns);
+            fflush(stdout);
+        }
+
+        if (args->live_duration > 0 && stats.hops * nslide >= (unsigned long) args->live_duration * samplerate)
+            break;
+
+        frames_in = nslide;
+    }
+
+    sigaction(SIGINT, &old_action, NULL);
+
+    if (status == 0 && pa_simple_drain(playback, &error) < 0) {
+        printf(_("Error: Unable to drain PulseAudio playback: %s\n"), pa_strerror(error));
+        status = 1;
+    }
+
+    live_report(&stats, nslide, window_size, samplerate);
+
+    setk_stream_destroy(stream);
+    pa_simple_free(playback);
+    pa_simple_free(capture);
+
+    free(pcm);
+    free(in);
+    free(out);
+
+    return status;
+}
+
+/* SIGINT handler */
+static void live_interrupt(int sig) {
+    live_stop = 1;
+}
+
+/* monotonic clock in microseconds */
+static double live_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* open PulseAudio stream, device NULL is the default one */
+static pa_simple *live_open(pa_stream_direction_t direction, const char *device, const pa_sample_spec *spec,
+                            const pa_buffer_attr *attr) {
+    pa_simple *stream;
+    int error;
+
+    stream = pa_simple_new(NULL, "Sound Enhancement Toolkit", direction, device,
+                           direction == PA_STREAM_RECORD ? "Noisy input" : "Enhanced output", spec, NULL, attr,
+                           &error);
+    if (stream == NULL)
+        printf(_("Error: Unable to open PulseAudio %s '%s': %s\n"),
+               direction == PA_STREAM_RECORD ? _("source") : _("sink"), device ? device : _("default"),
+               pa_strerror(error));
+
+    return stream;
+}
+
+/* print statistics of live stream */
+static void live_report(const live_stats_t *stats, int nslide, int window_size, int samplerate) {
+    double hop_ms = 1e3 * nslide / samplerate;
+
+    printf(_("\n-----------------------------------------\n"));
+    printf(_("Live stream duration: %s\n"), show_time(samplerate, (int) (stats->hops * nslide)));
+    printf(_("Hops: %lu of %.2f ms\n"), stats->hops, hop_ms);
+    if (stats->hops > 0)
+        printf(_("End-to-end latency: mean %.1f ms, max %.1f ms (frame %.1f ms)\n"),
+               stats->latency_sum / stats->hops / 1000, stats->latency_max / 1000,
+               1e3 * window_size / samplerate);
+    printf(_("Processing of hop: max %.2f ms\n"), stats->process_max / 1000);
+    printf(_("Late hops: %lu\n"), stats->late_hops);
+    printf(_("Capture overruns: %lu\n"), stats->overruns);
+    printf(_("Playback underruns: %lu\n"), stats->underruns);
+    printf(_("-----------------------------------------\n"));
+}
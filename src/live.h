@@ -0,0 +1,37 @@
+/********************************************************************
+ function: Live Mode
+ contains: real-time capture from PulseAudio source, frame processor
+           and playback to PulseAudio sink
+ ********************************************************************/
+
+#ifndef HAVE_LIVE_H
+#define HAVE_LIVE_H
+
+#include "common.h"
+#include "toolkit.h"
+
+/* default samplerate of live stream */
+#define LIVE_SAMPLERATE_DEFAULT             16000
+
+/* capture buffer holds this number of hops, older input is dropped by server */
+#define LIVE_CAPTURE_HOPS                   8
+
+/* playback buffer target in hops */
+#define LIVE_PLAYBACK_HOPS                  2
+
+/* statistics of live stream, times are in microseconds */
+typedef struct live_stats_t {
+    unsigned long hops;
+    unsigned long late_hops;                /* processing of hop took longer than hop duration */
+    unsigned long overruns;                 /* capture buffer was full, input was lost */
+    unsigned long underruns;                /* playback buffer ran empty before next hop */
+    double latency_sum;                     /* end-to-end latency, capture + frame + playback */
+    double latency_max;
+    double process_max;
+} live_stats_t;
+
+/* capture from args->live_source, enhance and play back to args->live_sink (NULL is default
+ * device) until args->live_duration seconds elapsed or SIGINT, 0 runs until SIGINT */
+extern int process_live(const setk_options_t *args);
+
+#endif
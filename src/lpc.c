@@ -45,18 +45,15 @@ Carsten Bormann
 
 #include <stdlib.h>
 #include <string.h>
-#include <alloca.h>
 #include "lpc.h"
 
 /* Autocorrelation LPC coeff generation algorithm invented by
    N. Levinson in 1947, modified by J. Durbin in 1959. */
 
-/* Input : n elements of time doamin data
+/* Input : n elements of time doamin data, aut work buffer of m+1 elements
    Output: m lpc coefficients, excitation energy */
 
-double lpc_from_data(double *data, double *lpc, int n, int m) {
-    double *aut = alloca(sizeof(*aut) * (m + 1));
-    double error;
+double lpc_from_data(real_t *data, real_t *lpc, int n, int m, real_t *aut) {
     int i, j;
 
     /* autocorrelation, p+1 lag coefficients */
@@ -67,6 +64,16 @@ double lpc_from_data(double *data, double *lpc, int n, int m) {
         aut[j] = d;
     }
 
+    return lpc_from_autocorr(aut, lpc, m);
+}
+
+/* Input : m+1 autocorrelation lags
+   Output: m lpc coefficients, excitation energy */
+
+double lpc_from_autocorr(const real_t *aut, real_t *lpc, int m) {
+    double error;
+    int i, j;
+
     /* Generate lpc coefficients from autocorr values */
 
     error = aut[0];
@@ -107,16 +114,36 @@ double lpc_from_data(double *data, double *lpc, int n, int m) {
     return error;
 }
 
-void lpc_predict(double *coeff, double *prime, int m,
-                 double *data, long n) {
+/* Input : fft_size/2+1 bins of power spectrum, backward halfcomplex
+           plan of fft_size, work buffer of fft_size elements with
+           alignment of fftw_alloc_real()
+   Output: m lpc coefficients, excitation energy scaled by fft_size
+
+   Autocorrelation is inverse FFT of power spectrum (Wiener-Khinchin),
+   it is circular, i.e. equal to lpc_from_data() of zero padded data
+   for lags below fft_size minus length of data. */
+
+double lpc_from_power_spectrum(const real_t *ps, size_t fft_size, fft_plan_t fft_back, real_t *lpc, int m,
+                               real_t *work) {
+    /* power spectrum is real, imaginary half of halfcomplex array is zero */
+    memcpy((void *) work, (void *) ps, sizeof(*work) * (fft_size / 2 + 1));
+    memset((void *) (work + fft_size / 2 + 1), 0, sizeof(*work) * (fft_size - fft_size / 2 - 1));
+
+    FFTW(execute_r2r)(fft_back, work, work);
+
+    return lpc_from_autocorr(work, lpc, m);
+}
+
+void lpc_predict(real_t *coeff, real_t *prime, int m,
+                 real_t *data, long n, real_t *work) {
 
     /* in: coeff[0...m-1] LPC coefficients
            prime[0...m-1] initial values (allocated size of n+m-1)
+           work[0...m+n-1] work buffer
       out: data[0...n-1] data samples */
 
     long i, j, o, p;
     double y;
-    double *work = alloca(sizeof(*work) * (m + n));
 
     if (!prime)
         for (i = 0; i < m; i++)
@@ -18,10 +18,23 @@
 #ifndef HAVE_LPC_H
 #define HAVE_LPC_H
 
-/* simple linear scale LPC code */
-extern double lpc_from_data(double *data, double *lpc, int n, int m);
+#include "common.h"
+#include "fft.h"
 
-extern void lpc_predict(double *coeff, double *prime, int m,
-                        double *data, long n);
+/* simple linear scale LPC code, work buffers are provided by caller,
+   aut holds m+1 elements, its autocorrelation lags */
+extern double lpc_from_data(real_t *data, real_t *lpc, int n, int m, real_t *aut);
+
+/* Levinson-Durbin recursion on m+1 autocorrelation lags */
+extern double lpc_from_autocorr(const real_t *aut, real_t *lpc, int m);
+
+/* LPC of fft_size/2+1 bins of power spectrum, autocorrelation is computed
+   by inverse FFT into work buffer of fft_size */
+extern double lpc_from_power_spectrum(const real_t *ps, size_t fft_size, fft_plan_t fft_back, real_t *lpc, int m,
+                                      real_t *work);
+
+/* extrapolation of n samples from m primed ones, work holds m+n elements */
+extern void lpc_predict(real_t *coeff, real_t *prime, int m,
+                        real_t *data, long n, real_t *work);
 
 #endif
@@ -0,0 +1,460 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "mapped.h"
+#include "i18n.h"
+
+/* WAV format tags */
+#define WAV_FORMAT_PCM                      0x0001
+#define WAV_FORMAT_FLOAT                    0x0003
+#define WAV_FORMAT_EXTENSIBLE               0xFFFE
+
+/* bytes per sample of subtype, 0 when subtype has no fast path */
+static int mapped_sample_bytes(int subtype);
+
+/* find fmt and data chunk of WAV file, returns 0 on success */
+static int parse_wav(const unsigned char *map, size_t length, int *tag, int *channels, int *samplerate,
+                     int *bits, size_t *data_offset, size_t *data_bytes);
+
+/* write WAV header of frames into header, returns its size, fact_offset is 0 without fact chunk */
+static size_t wav_header(unsigned char *header, const SF_INFO *info, int subtype, int bytes, sf_count_t frames,
+                         const mapped_tags_t *tags, size_t *fact_offset);
+
+/* append INFO string to LIST chunk at p, returns its size */
+static size_t wav_info_string(unsigned char *p, const char *id, const char *str);
+
+/* little endian integers */
+static inline unsigned get_le16(const unsigned char *p) {
+    return p[0] | (unsigned) p[1] << 8;
+}
+
+static inline uint32_t get_le32(const unsigned char *p) {
+    return p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static inline void put_le16(unsigned char *p, unsigned value) {
+    p[0] = (unsigned char) value;
+    p[1] = (unsigned char) (value >> 8);
+}
+
+static inline void put_le32(unsigned char *p, uint32_t value) {
+    p[0] = (unsigned char) value;
+    p[1] = (unsigned char) (value >> 8);
+    p[2] = (unsigned char) (value >> 16);
+    p[3] = (unsigned char) (value >> 24);
+}
+
+/* sample of file as normalized value, scaling is the same as in libsndfile */
+static inline double mapped_sample(const unsigned char *p, int subtype) {
+    int16_t s16;
+    float f32;
+
+    switch (subtype) {
+        case SF_FORMAT_PCM_16:
+            memcpy(&s16, p, sizeof(s16));
+            return s16 / 32768.0;
+        case SF_FORMAT_PCM_24:
+            return (int32_t) ((uint32_t) p[0] << 8 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 24) /
+                   2147483648.0;
+        default:
+            memcpy(&f32, p, sizeof(f32));
+            return f32;
+    }
+}
+
+/* store normalized value as sample of file, conversion is the same as in libsndfile, which does not clip
+ * unless SFC_SET_CLIPPING is set, rounded value is truncated to width of sample */
+static inline void mapped_store(unsigned char *p, int subtype, double value) {
+    int16_t s16;
+    int32_t s32;
+    float f32;
+
+    switch (subtype) {
+        case SF_FORMAT_PCM_16:
+            s16 = (int16_t) lrint(value * 0x7FFF);
+            memcpy(p, &s16, sizeof(s16));
+            break;
+        case SF_FORMAT_PCM_24:
+            s32 = (int32_t) lrint(value * 0x7FFFFF);
+            p[0] = (unsigned char) s32;
+            p[1] = (unsigned char) (s32 >> 8);
+            p[2] = (unsigned char) (s32 >> 16);
+            break;
+        default:
+            f32 = (float) value;
+            memcpy(p, &f32, sizeof(f32));
+            break;
+    }
+}
+
+/* map input file which was opened by libsndfile as info */
+setk_mapped_t *mapped_open_input(const char *filename, const SF_INFO *info) {
+    int major = info->format & SF_FORMAT_TYPEMASK;
+    int subtype = info->format & SF_FORMAT_SUBMASK;
+    int endian = info->format & SF_FORMAT_ENDMASK;
+    int bytes = mapped_sample_bytes(subtype);
+    int tag = 0, channels = 0, samplerate = 0, bits = 0;
+    size_t data_offset = 0, data_bytes;
+    setk_mapped_t *mapped;
+    struct stat st;
+    unsigned char *map;
+    int fd;
+
+    /* samples are converted in host byte order */
+    if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__ || bytes == 0 || info->frames <= 0 ||
+        (major != SF_FORMAT_WAV && major != SF_FORMAT_WAVEX && major != SF_FORMAT_RAW) ||
+        (endian != SF_ENDIAN_FILE && endian != SF_ENDIAN_LITTLE))
+        return NULL;
+
+    if ((fd = open(filename, O_RDONLY)) < 0)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+        (map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    /* file is read once from start to end */
+    madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+    data_bytes = (size_t) st.st_size;
+
+    /* header must describe the same samples as libsndfile found, otherwise libsndfile is used */
+    if (major != SF_FORMAT_RAW &&
+        (parse_wav(map, (size_t) st.st_size, &tag, &channels, &samplerate, &bits, &data_offset,
+                   &data_bytes) != 0 ||
+         tag != (subtype == SF_FORMAT_FLOAT ? WAV_FORMAT_FLOAT : WAV_FORMAT_PCM) || bits != bytes * 8 ||
+         channels != info->channels || samplerate != info->samplerate)) {
+        munmap(map, (size_t) st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    if ((sf_count_t) (data_bytes / ((size_t) bytes * info->channels)) != info->frames) {
+        munmap(map, (size_t) st.st_size);
+        close(fd);
+        return NULL;
+    }
+
+    if ((mapped = (setk_mapped_t *) calloc(1, sizeof(*mapped))) == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    mapped->fd = fd;
+    mapped->map = map;
+    mapped->length = (size_t) st.st_size;
+    mapped->data = map + data_offset;
+    mapped->data_offset = data_offset;
+    mapped->subtype = subtype;
+    mapped->bytes = bytes;
+    mapped->channels = info->channels;
+    mapped->frames = info->frames;
+    mapped->wav = (major != SF_FORMAT_RAW);
+
+    return mapped;
+}
+
+/* create output file of frames in format of info and map it */
+setk_mapped_t *mapped_create_output(const char *filename, const SF_INFO *info, sf_count_t frames,
+                                    const mapped_tags_t *tags) {
+    int major = info->format & SF_FORMAT_TYPEMASK;
+    int subtype = info->format & SF_FORMAT_SUBMASK;
+    int endian = info->format & SF_FORMAT_ENDMASK;
+    int bytes = mapped_sample_bytes(subtype);
+    size_t header_size = 0, fact_offset = 0, data_bytes, length;
+    setk_mapped_t *mapped;
+    unsigned char *map;
+    int fd;
+
+    /* WAVEX header and big endian files are left to libsndfile */
+    if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__ || bytes == 0 || frames <= 0 ||
+        (major != SF_FORMAT_WAV && major != SF_FORMAT_RAW) ||
+        (endian != SF_ENDIAN_FILE && endian != SF_ENDIAN_LITTLE))
+        return NULL;
+
+    /* data chunk of WAV is padded to even size */
+    data_bytes = (size_t) frames * info->channels * bytes;
+    if (major == SF_FORMAT_WAV) {
+        if (data_bytes > UINT32_MAX - 1024)
+            return NULL;
+        header_size = wav_header(NULL, info, subtype, bytes, frames, tags, &fact_offset);
+    }
+    length = header_size + data_bytes + (major == SF_FORMAT_WAV ? data_bytes % 2 : 0);
+
+    if ((fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666)) < 0)
+        return NULL;
+
+    /* blocks are allocated now, so a full disk does not fault writes into map */
+    if (ftruncate(fd, (off_t) length) != 0 || posix_fallocate(fd, 0, (off_t) length) != 0 ||
+        (map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    if ((mapped = (setk_mapped_t *) calloc(1, sizeof(*mapped))) == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    if (major == SF_FORMAT_WAV)
+        wav_header(map, info, subtype, bytes, frames, tags, &fact_offset);
+
+    mapped->fd = fd;
+    mapped->map = map;
+    mapped->length = length;
+    mapped->data = map + header_size;
+    mapped->data_offset = header_size;
+    mapped->fact_offset = fact_offset;
+    mapped->subtype = subtype;
+    mapped->bytes = bytes;
+    mapped->channels = info->channels;
+    mapped->frames = frames;
+    mapped->wav = (major == SF_FORMAT_WAV);
+    mapped->writable = true;
+
+    return mapped;
+}
+
+/* convert next frames of input */
+sf_count_t mapped_read(setk_mapped_t *mapped, real_t *data, sf_count_t frames) {
+    sf_count_t count = mapped_read_at(mapped, mapped->pos, data, frames);
+
+    mapped->pos += count;
+    return count;
+}
+
+/* convert frames of input from frame pos */
+sf_count_t mapped_read_at(const setk_mapped_t *mapped, sf_count_t pos, real_t *data, sf_count_t frames) {
+    sf_count_t count = MAX(0, MIN(frames, mapped->frames - pos));
+    const unsigned char *src = mapped->data + (size_t) pos * mapped->channels * mapped->bytes;
+    size_t samples = (size_t) count * mapped->channels;
+    int16_t s16;
+    float f32;
+
+    /* loops of one subtype are vectorized by compiler */
+    if (mapped->subtype == SF_FORMAT_PCM_16) {
+        for (size_t i = 0; i < samples; ++i) {
+            memcpy(&s16, src + i * sizeof(s16), sizeof(s16));
+            data[i] = s16 / 32768.0;
+        }
+    }
+    else if (mapped->subtype == SF_FORMAT_FLOAT) {
+        for (size_t i = 0; i < samples; ++i) {
+            memcpy(&f32, src + i * sizeof(f32), sizeof(f32));
+            data[i] = f32;
+        }
+    }
+    else {
+        for (size_t i = 0; i < samples; ++i)
+            data[i] = mapped_sample(src + i * mapped->bytes, mapped->subtype);
+    }
+
+    return count;
+}
+
+/* convert frames into output */
+sf_count_t mapped_write(setk_mapped_t *mapped, const real_t *data, sf_count_t frames) {
+    sf_count_t count = mapped_write_at(mapped, mapped->pos, data, frames);
+
+    mapped->pos += count;
+    return count;
+}
+
+/* convert frames into output from frame pos */
+sf_count_t mapped_write_at(setk_mapped_t *mapped, sf_count_t pos, const real_t *data, sf_count_t frames) {
+    sf_count_t count = MAX(0, MIN(frames, mapped->frames - pos));
+    unsigned char *dst = mapped->data + (size_t) pos * mapped->channels * mapped->bytes;
+    size_t samples = (size_t) count * mapped->channels;
+
+    for (size_t i = 0; i < samples; ++i)
+        mapped_store(dst + i * mapped->bytes, mapped->subtype, data[i]);
+
+    return count;
+}
+
+/* unmap and close file */
+int mapped_close(setk_mapped_t *mapped) {
+    size_t data_bytes, length;
+    int status = 0;
+
+    if (mapped == NULL)
+        return 0;
+
+    /* output was not completed, e.g. processing failed, sizes in header must match written samples */
+    if (mapped->writable && mapped->pos < mapped->frames) {
+        data_bytes = (size_t) mapped->pos * mapped->channels * mapped->bytes;
+        length = mapped->data_offset + data_bytes + (mapped->wav ? data_bytes % 2 : 0);
+
+        if (mapped->wav) {
+            put_le32(mapped->map + 4, (uint32_t) (length - 8));
+            put_le32(mapped->data - 4, (uint32_t) data_bytes);
+            if (mapped->fact_offset > 0)
+                put_le32(mapped->map + mapped->fact_offset, (uint32_t) mapped->pos);
+            if (data_bytes % 2)
+                mapped->data[data_bytes] = 0;
+        }
+
+        munmap(mapped->map, mapped->length);
+        if (ftruncate(mapped->fd, (off_t) length) != 0)
+            status = 1;
+    }
+    else
+        munmap(mapped->map, mapped->length);
+
+    if (close(mapped->fd) != 0)
+        status = 1;
+
+    free(mapped);
+    return status;
+}
+
+/* bytes per sample of subtype */
+static int mapped_sample_bytes(int subtype) {
+    switch (subtype) {
+        case SF_FORMAT_PCM_16:
+            return 2;
+        case SF_FORMAT_PCM_24:
+            return 3;
+        case SF_FORMAT_FLOAT:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/* find fmt and data chunk of WAV file, chunks are word aligned */
+static int parse_wav(const unsigned char *map, size_t length, int *tag, int *channels, int *samplerate,
+                     int *bits, size_t *data_offset, size_t *data_bytes) {
+    size_t pos = 12, size;
+    bool fmt = false;
+
+    if (length < 12 || memcmp(map, "RIFF", 4) != 0 || memcmp(map + 8, "WAVE", 4) != 0)
+        return -1;
+
+    while (pos + 8 <= length) {
+        size = get_le32(map + pos + 4);
+
+        if (memcmp(map + pos, "fmt ", 4) == 0) {
+            if (size < 16 || pos + 8 + size > length)
+                return -1;
+
+            *tag = (int) get_le16(map + pos + 8);
+            *channels = (int) get_le16(map + pos + 10);
+            *samplerate = (int) get_le32(map + pos + 12);
+            *bits = (int) get_le16(map + pos + 22);
+
+            /* extensible format has tag of subformat at start of its GUID */
+            if (*tag == WAV_FORMAT_EXTENSIBLE && size >= 26)
+                *tag = (int) get_le16(map + pos + 32);
+            fmt = true;
+        }
+        else if (memcmp(map + pos, "data", 4) == 0) {
+            /* data of truncated file ends with file, as in libsndfile */
+            *data_offset = pos + 8;
+            *data_bytes = MIN(size, length - *data_offset);
+            return fmt ? 0 : -1;
+        }
+
+        pos += 8 + size + size % 2;
+    }
+
+    return -1;
+}
+
+/* write WAV header of frames, header is only measured when it is NULL */
+static size_t wav_header(unsigned char *header, const SF_INFO *info, int subtype, int bytes, sf_count_t frames,
+                         const mapped_tags_t *tags, size_t *fact_offset) {
+    size_t data_bytes = (size_t) frames * info->channels * bytes;
+    size_t list_size = 0, size, pos = 12;
+
+    /* LIST chunk of INFO strings precedes data */
+    if (tags != NULL)
+        list_size = 4 + wav_info_string(NULL, "INAM", tags->title) + wav_info_string(NULL, "ICMT", tags->comment) +
+                    wav_info_string(NULL, "ISFT", tags->software) + wav_info_string(NULL, "ICOP", tags->copyright);
+
+    /* samples which are not PCM need number of frames in fact chunk */
+    *fact_offset = (subtype == SF_FORMAT_FLOAT) ? 12 + 24 + 8 : 0;
+    size = 12 + 24 + (*fact_offset > 0 ? 12 : 0) + (list_size > 0 ? 8 + list_size : 0) + 8;
+    if (header == NULL)
+        return size;
+
+    memcpy(header, "RIFF", 4);
+    put_le32(header + 4, (uint32_t) (size + data_bytes + data_bytes % 2 - 8));
+    memcpy(header + 8, "WAVE", 4);
+
+    memcpy(header + pos, "fmt ", 4);
+    put_le32(header + pos + 4, 16);
+    put_le16(header + pos + 8, subtype == SF_FORMAT_FLOAT ? WAV_FORMAT_FLOAT : WAV_FORMAT_PCM);
+    put_le16(header + pos + 10, (unsigned) info->channels);
+    put_le32(header + pos + 12, (uint32_t) info->samplerate);
+    put_le32(header + pos + 16, (uint32_t) (info->samplerate * info->channels * bytes));
+    put_le16(header + pos + 20, (unsigned) (info->channels * bytes));
+    put_le16(header + pos + 22, (unsigned) (bytes * 8));
+    pos += 24;
+
+    if (*fact_offset > 0) {
+        memcpy(header + pos, "fact", 4);
+        put_le32(header + pos + 4, 4);
+        put_le32(header + pos + 8, (uint32_t) frames);
+        pos += 12;
+    }
+
+    if (list_size > 0) {
+        memcpy(header + pos, "LIST", 4);
+        put_le32(header + pos + 4, (uint32_t) list_size);
+        memcpy(header + pos + 8, "INFO", 4);
+        pos += 12;
+        pos += wav_info_string(header + pos, "INAM", tags->title);
+        pos += wav_info_string(header + pos, "ICMT", tags->comment);
+        pos += wav_info_string(header + pos, "ISFT", tags->software);
+        pos += wav_info_string(header + pos, "ICOP", tags->copyright);
+    }
+
+    memcpy(header + pos, "data", 4);
+    put_le32(header + pos + 4, (uint32_t) data_bytes);
+
+    return size;
+}
+
+/* append INFO string to LIST chunk, string is zero terminated and padded to even size */
+static size_t wav_info_string(unsigned char *p, const char *id, const char *str) {
+    size_t len;
+
+    if (str == NULL)
+        return 0;
+
+    len = strlen(str) + 1;
+    if (p != NULL) {
+        memcpy(p, id, 4);
+        put_le32(p + 4, (uint32_t) len);
+        memcpy(p + 8, str, len);
+        if (len % 2)
+            p[8 + len] = 0;
+    }
+
+    return 8 + len + len % 2;
+}
@@ -0,0 +1,64 @@
+/********************************************************************
+ function: Memory mapped audio files
+ contains: fast path for uncompressed PCM WAV and raw files, samples
+           are converted straight between mapped file and frames
+ ********************************************************************/
+
+#ifndef HAVE_MAPPED_H
+#define HAVE_MAPPED_H
+
+#include "common.h"
+
+/* INFO strings of WAV output, as set by sf_set_string() on libsndfile output */
+typedef struct mapped_tags_t {
+    const char *title;
+    const char *comment;
+    const char *software;
+    const char *copyright;
+} mapped_tags_t;
+
+/* mapped file, samples are 16 or 24 bit little endian PCM or 32 bit float */
+typedef struct setk_mapped_t {
+    int fd;
+    unsigned char *map;                     /* whole file */
+    size_t length;                          /* bytes of map */
+    unsigned char *data;                    /* first sample */
+    size_t data_offset;                     /* offset of first sample in file */
+    size_t fact_offset;                     /* offset of frames in fact chunk of output, 0 without it */
+    int subtype;                            /* SF_FORMAT_PCM_16, SF_FORMAT_PCM_24 or SF_FORMAT_FLOAT */
+    int bytes;                              /* bytes per sample */
+    int channels;                           /* channels of file */
+    sf_count_t frames;                      /* frames of file, preallocated frames of output */
+    sf_count_t pos;                         /* next frame which is read or written, end of output on close */
+    bool wav;                               /* output has WAV header, which is fixed on close */
+    bool writable;
+} setk_mapped_t;
+
+/* map input file which was opened by libsndfile as info, returns NULL when file has no fast path,
+ * e.g. it is compressed, then libsndfile is used */
+extern setk_mapped_t *mapped_open_input(const char *filename, const SF_INFO *info);
+
+/* create output file of frames in format of info and map it, header is written at once,
+ * returns NULL when format has no fast path or file cannot be created */
+extern setk_mapped_t *mapped_create_output(const char *filename, const SF_INFO *info, sf_count_t frames,
+                                           const mapped_tags_t *tags);
+
+/* convert next frames of input, returns number of frames, 0 at end of file */
+extern sf_count_t mapped_read(setk_mapped_t *mapped, real_t *data, sf_count_t frames);
+
+/* convert frames of input from frame pos, position of file is kept, so disjoint parts of file
+ * may be read by parallel threads, returns number of frames, 0 at end of file */
+extern sf_count_t mapped_read_at(const setk_mapped_t *mapped, sf_count_t pos, real_t *data, sf_count_t frames);
+
+/* convert frames into output as libsndfile does, returns number of frames which fit into file */
+extern sf_count_t mapped_write(setk_mapped_t *mapped, const real_t *data, sf_count_t frames);
+
+/* convert frames into output from frame pos, position of file is kept, so disjoint parts of file
+ * may be written by parallel threads, returns number of frames which fit into file */
+extern sf_count_t mapped_write_at(setk_mapped_t *mapped, sf_count_t pos, const real_t *data, sf_count_t frames);
+
+/* unmap and close file, output shorter than preallocated is truncated and its header is fixed,
+ * returns 0 on success */
+extern int mapped_close(setk_mapped_t *mapped);
+
+#endif
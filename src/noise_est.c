@@ -1,7 +1,12 @@
 #include "noise_est.h"
+#include "noise_est_bin.h"
 #include "i18n.h"
 #include <string.h>
 
+/* run per-bin kernel over all bins of frame */
+static inline double estimate_frame(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size,
+                                    real_t *noise_ps, double SNRseg, noise_est_bin_func_t noise_bin);
+
 noise_est_func_t parse_noise_est_type(const char *name, bool verbose) {
     if (name == NULL) {
         if (verbose)
@@ -42,231 +47,58 @@ char *get_noise_est_name(const char *name) {
     return (_("VAD estimation (default)"));
 }
 
-/* hirsch noise estimation */
-double hirsch_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate) {
-    /* initialize static variables */
-    static double P[FFT_MAX / 2 + 1];
-    static double noise_ps_old[FFT_MAX / 2 + 1];
-    static int n = 1; /* check number of calls */
-    const double as = 0.85;
-    const double beta = 1.5;
-    double norm_ns_ps = 0.0;
-
-    int i;
-
-    if (n == 1) {
-        memcpy((void *) P, (void *) ns_ps, sizeof(*P) * (fft_size / 2 + 1));
-        memcpy((void *) noise_ps_old, (void *) ns_ps, sizeof(*noise_ps) * (fft_size / 2 + 1));
-
-        for (i = 0; i <= fft_size / 2; ++i)
-            norm_ns_ps += noise_ps_old[i];
-    }
-    else {
-        for (i = 0; i <= fft_size / 2; ++i) {
-            P[i] = as * P[i] + (1 - as) * ns_ps[i];
-            if (P[i] < beta * noise_ps_old[i])
-                noise_ps_old[i] = as * noise_ps_old[i] + (1 - as) * P[i];
-
-            norm_ns_ps += noise_ps_old[i];
-        }
-    }
+/* short name of noise estimation algorithm */
+const char *get_noise_est_id(noise_est_func_t noise_estimation) {
+    if (noise_estimation == hirsch_estimation)
+        return "hirsch";
+    if (noise_estimation == doblinger_estimation)
+        return "doblinger";
+    if (noise_estimation == mcra_estimation)
+        return "mcra";
+    if (noise_estimation == mcra2_estimation)
+        return "mcra2";
+
+    return "vad";
+}
 
-    n++;
-    memcpy((void *) noise_ps, (void *) noise_ps_old, sizeof(*noise_ps) * (fft_size / 2 + 1));
-    return norm_ns_ps;
+/* hirsch noise estimation */
+double hirsch_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                         double SNRseg, int samplerate) {
+    return estimate_frame(state, ns_ps, fft_size, noise_ps, SNRseg, hirsch_bin);
 }
 
 /* simple VAD noise estimation */
-double vad_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate) {
-    static double noise_ps_old[FFT_MAX / 2 + 1];
-    const int nf_sabsent = 6; /* speech absent frames */
-    const double thres = 3.0;
-    const double G = 0.9;
-    static int frame = 0;
-    double norm_ns_ps = 0.0;
-
-    int i;
-
-    if (frame < nf_sabsent) {
-        for (i = 0; i <= fft_size / 2; ++i) {
-            noise_ps_old[i] = noise_ps_old[i] + ns_ps[i] / nf_sabsent;
-            norm_ns_ps += noise_ps_old[i];
-        }
-    }
-    else {
-        /* --- implement a simple VAD detector -------------- */
-        for (i = 0; i <= fft_size / 2; ++i) {
-            if (SNRseg < thres) {
-                noise_ps_old[i] = G * noise_ps_old[i] + (1 - G) * ns_ps[i];
-            }
-            norm_ns_ps += noise_ps_old[i];
-        }
-    }
-
-    frame++;
-    memcpy((void *) noise_ps, (void *) noise_ps_old, sizeof(*noise_ps) * (fft_size / 2 + 1));
-    return norm_ns_ps;
+double vad_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                      double SNRseg, int samplerate) {
+    return estimate_frame(state, ns_ps, fft_size, noise_ps, SNRseg, vad_bin);
 }
 
 /* doblinger noise estimation */
-double doblinger_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate) {
-    /* initialize static variables */
-    static double pxk_old[FFT_MAX / 2 + 1];
-    static double pnk_old[FFT_MAX / 2 + 1];
-    const double alpha = 0.7;
-    const double beta = 0.96;
-    const double gamma = 0.998;
-    static int n = 1; /* check number of calls */
-    double pxk, pnk;
-    double norm_ns_ps = 0.0;
-    int i;
-
-    if (n == 1) {
-        memcpy((void *) pxk_old, (void *) ns_ps, sizeof(*pxk_old) * (fft_size / 2 + 1));
-        memcpy((void *) pnk_old, (void *) ns_ps, sizeof(*pnk_old) * (fft_size / 2 + 1));
-
-        for (i = 0; i <= fft_size / 2; ++i)
-            norm_ns_ps += pnk_old[i];
-    }
-    else {
-        for (i = 0; i <= fft_size / 2; ++i) {
-            pxk = alpha * pxk_old[i] + (1 - alpha) * ns_ps[i];
-            if (pnk_old[i] <= pxk)
-                pnk = (gamma * pnk_old[i]) + (((1 - gamma) / (1 - beta)) * (pxk - beta * pxk_old[i]));
-            else
-                pnk = pxk;
-
-            norm_ns_ps += pnk;
-            pxk_old[i] = pxk;
-            pnk_old[i] = pnk;
-        }
-    }
-
-    n++;
-    memcpy((void *) noise_ps, (void *) pnk_old, sizeof(*noise_ps) * (fft_size / 2 + 1));
-    return norm_ns_ps;
+double doblinger_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                            double SNRseg, int samplerate) {
+    return estimate_frame(state, ns_ps, fft_size, noise_ps, SNRseg, doblinger_bin);
 }
 
 /* mcra noise estimation */
-double mcra_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate) {
-    /* initialize static variables */
-    static double P[FFT_MAX / 2 + 1];
-    static double P_min[FFT_MAX / 2 + 1];
-    static double P_tmp[FFT_MAX / 2 + 1];
-    static double pk[FFT_MAX / 2 + 1];
-    static double noise_ps_old[FFT_MAX / 2 + 1];
-    const double ad = 0.95;
-    const double as = 0.8;
-    const int L = 100;
-    const int delta = 5;
-    const double ap = 0.2;
-    double Srk, adk;
-    int Ikl;
-    static int n = 1; /* check number of calls */
-    double norm_ns_ps = 0.0;
-    int i;
-
-    if (n == 1) {
-        memcpy((void *) P, (void *) ns_ps, sizeof(*P) * (fft_size / 2 + 1));
-        memcpy((void *) P_min, (void *) ns_ps, sizeof(*P_min) * (fft_size / 2 + 1));
-        memcpy((void *) P_tmp, (void *) ns_ps, sizeof(*P_tmp) * (fft_size / 2 + 1));
-        memcpy((void *) noise_ps_old, (void *) ns_ps, sizeof(*noise_ps_old) * (fft_size / 2 + 1));
-
-        for (i = 0; i <= fft_size / 2; ++i)
-            norm_ns_ps += P[i];
-    }
-    else {
-        for (i = 0; i <= fft_size / 2; ++i) {
-            P[i] = as * P[i] + (1 - as) * ns_ps[i];
-
-            if (n % L == 0) {
-                P_min[i] = MIN (P_tmp[i], P[i]);
-                P_tmp[i] = P[i];
-            }
-            else {
-                P_min[i] = MIN (P_min[i], P[i]);
-                P_tmp[i] = MIN (P_tmp[i], P[i]);
-            }
-
-            Srk = check_nan(P[i] / P_min[i]);
-
-            Ikl = (Srk > delta) ? 1 : 0;
-
-            pk[i] = ap * pk[i] + (1 - ap) * Ikl;
-
-            adk = ad + (1 - ad) * pk[i];
-
-            noise_ps_old[i] = adk * noise_ps_old[i] + (1 - adk) * ns_ps[i];
-
-            norm_ns_ps += noise_ps_old[i];
-        }
-    }
-
-    n++;
-    memcpy((void *) noise_ps, (void *) noise_ps_old, sizeof(*noise_ps) * (fft_size / 2 + 1));
-    return norm_ns_ps;
+double mcra_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                       double SNRseg, int samplerate) {
+    return estimate_frame(state, ns_ps, fft_size, noise_ps, SNRseg, mcra_bin);
 }
 
 /* mcra 2  noise estimation */
-double mcra2_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate) {
-    /* initialize static variables */
-    static double noise_ps_old[FFT_MAX / 2 + 1];
-    static double pxk_old[FFT_MAX / 2 + 1];
-    static double pnk_old[FFT_MAX / 2 + 1];
-    static double pk[FFT_MAX / 2 + 1];
-    static double delta[FFT_MAX / 2 + 1];
-    const double ad = 0.95;
-    const double ap = 0.2;
-    const double beta = 0.8;
-    const double gamma = 0.998;
-    const double alpha = 0.7;
-    int freq_res = samplerate / (int) fft_size;
-    int k_1khz = 1000 / freq_res;
-    int k_3khz = 3000 / freq_res;
-    static int n = 1; /* check number of calls */
-    double Srk, adk;
-    int Ikl;
-    double pxk, pnk;
-    double norm_ns_ps = 0.0;
-
-    if (n == 1) {
-        memcpy((void *) pxk_old, (void *) ns_ps, sizeof(*pxk_old) * (fft_size / 2 + 1));
-        memcpy((void *) pnk_old, (void *) ns_ps, sizeof(*pnk_old) * (fft_size / 2 + 1));
-        memcpy((void *) noise_ps_old, (void *) ns_ps, sizeof(*noise_ps_old) * (fft_size / 2 + 1));
-
-        /* calculate delta */
-        for (size_t i = 0; i <= fft_size / 2; ++i) {
-            if (i < k_1khz)
-                delta[i] = 2;
-            if (i >= k_1khz && i < k_3khz)
-                delta[i] = 2;
-            else
-                delta[i] = 5;
-
-            norm_ns_ps += noise_ps_old[i];
-        }
-    }
-    else {
-        for (size_t i = 0; i <= fft_size / 2; ++i) {
-            pxk = alpha * pxk_old[i] + (1 - alpha) * ns_ps[i];
-            if (pnk_old[i] <= pxk)
-                pnk = (gamma * pnk_old[i]) + (((1 - gamma) / (1 - beta)) * (pxk - beta * pxk_old[i]));
-            else
-                pnk = pxk;
+double mcra2_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                        double SNRseg, int samplerate) {
+    return estimate_frame(state, ns_ps, fft_size, noise_ps, SNRseg, mcra2_bin);
+}
 
-            norm_ns_ps += pnk;
-            pxk_old[i] = pxk;
-            pnk_old[i] = pnk;
+/* run per-bin kernel over all bins of frame, noise is written directly into noise_ps */
+static inline double estimate_frame(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size,
+                                    real_t *noise_ps, double SNRseg, noise_est_bin_func_t noise_bin) {
+    double norm_ns_ps = 0.0;
 
-            Srk = check_nan(pxk / pnk);
-            Ikl = (Srk > delta[i]) ? 1 : 0;
-            pk[i] = ap * pk[i] + (1 - ap) * Ikl;
-            adk = ad + (1 - ad) * pk[i];
-            noise_ps_old[i] = adk * noise_ps_old[i] + (1 - adk) * pxk;
-        }
-    }
+    for (size_t i = 0; i <= fft_size / 2; ++i)
+        noise_ps[i] = noise_bin(state, i, ns_ps[i], SNRseg, &norm_ns_ps);
 
-    n++;
-    memcpy((void *) noise_ps, (void *) noise_ps_old, sizeof(*noise_ps) * (fft_size / 2 + 1));
+    state->n++;
     return norm_ns_ps;
 }
@@ -9,25 +9,33 @@
 #define HAVE_NOISE_EST_H
 
 #include "common.h"
+#include "context.h"
 
-typedef double (*noise_est_func_t)(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg,
-                                   int samplerate);
+typedef double (*noise_est_func_t)(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                                   double SNRseg, int samplerate);
 
 extern noise_est_func_t parse_noise_est_type(const char *name, bool verbose);
 
 extern char *get_noise_est_name(const char *name);
 
+/* short name of noise estimation algorithm, e.g. "mcra", as accepted by parse_noise_est_type() */
+extern const char *get_noise_est_id(noise_est_func_t noise_estimation);
+
 /* Noise estimation algorithms */
 
-extern double hirsch_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate);
+extern double hirsch_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                                double SNRseg, int samplerate);
 
-extern double vad_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate);
+extern double vad_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                             double SNRseg, int samplerate);
 
-extern double doblinger_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg,
-                                   int samplerate);
+extern double doblinger_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                                   double SNRseg, int samplerate);
 
-extern double mcra_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate);
+extern double mcra_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                              double SNRseg, int samplerate);
 
-extern double mcra2_estimation(const double *ns_ps, size_t fft_size, double *noise_ps, double SNRseg, int samplerate);
+extern double mcra2_estimation(noise_est_state_t *state, const real_t *ns_ps, size_t fft_size, real_t *noise_ps,
+                               double SNRseg, int samplerate);
 
 #endif
@@ -0,0 +1,191 @@
+/********************************************************************
+ function: Noise Estimation Kernels
+ contains: per-bin steps of hirsch, vad, doblinger, mcra and mcra2
+           estimation, inlined into the frame loops of noise_est.c
+           and into fused sound enhancement sweeps
+ ********************************************************************/
+
+#ifndef HAVE_NOISE_EST_BIN_H
+#define HAVE_NOISE_EST_BIN_H
+
+#include "common.h"
+#include "context.h"
+
+/* estimate noise of bin i from its power ns_ps, contribution to the
+ * frame noise norm is added to norm_ns_ps, state->n is incremented by
+ * caller once all bins of the frame were processed */
+typedef double (*noise_est_bin_func_t)(noise_est_state_t *state, size_t i, real_t ns_ps, double SNRseg,
+                                       double *norm_ns_ps);
+
+/* hirsch noise estimation */
+static inline double hirsch_bin(noise_est_state_t *state, size_t i, real_t ns_ps, double SNRseg,
+                                double *norm_ns_ps) {
+    real_t *P = state->P;
+    real_t *noise_ps_old = state->noise_ps_old;
+    const double as = 0.85;
+    const double beta = 1.5;
+
+    if (state->n == 0) {
+        P[i] = ns_ps;
+        noise_ps_old[i] = ns_ps;
+    }
+    else {
+        P[i] = as * P[i] + (1 - as) * ns_ps;
+        if (P[i] < beta * noise_ps_old[i])
+            noise_ps_old[i] = as * noise_ps_old[i] + (1 - as) * P[i];
+    }
+
+    *norm_ns_ps += noise_ps_old[i];
+    return noise_ps_old[i];
+}
+
+/* simple VAD noise estimation */
+static inline double vad_bin(noise_est_state_t *state, size_t i, real_t ns_ps, double SNRseg,
+                             double *norm_ns_ps) {
+    real_t *noise_ps_old = state->noise_ps_old;
+    const int nf_sabsent = 6; /* speech absent frames */
+    const double thres = 3.0;
+    const double G = 0.9;
+
+    if (state->n < nf_sabsent)
+        noise_ps_old[i] = noise_ps_old[i] + ns_ps / nf_sabsent;
+    else if (SNRseg < thres) /* --- implement a simple VAD detector -------------- */
+        noise_ps_old[i] = G * noise_ps_old[i] + (1 - G) * ns_ps;
+
+    *norm_ns_ps += noise_ps_old[i];
+    return noise_ps_old[i];
+}
+
+/* doblinger noise estimation */
+static inline double doblinger_bin(noise_est_state_t *state, size_t i, real_t ns_ps, double SNRseg,
+                                   double *norm_ns_ps) {
+    real_t *pxk_old = state->pxk_old;
+    real_t *pnk_old = state->pnk_old;
+    const double alpha = 0.7;
+    const double beta = 0.96;
+    const double gamma = 0.998;
+    double pxk, pnk;
+
+    if (state->n == 0) {
+        pxk_old[i] = ns_ps;
+        pnk_old[i] = ns_ps;
+        *norm_ns_ps += pnk_old[i];
+    }
+    else {
+        pxk = alpha * pxk_old[i] + (1 - alpha) * ns_ps;
+        if (pnk_old[i] <= pxk)
+            pnk = (gamma * pnk_old[i]) + (((1 - gamma) / (1 - beta)) * (pxk - beta * pxk_old[i]));
+        else
+            pnk = pxk;
+
+        *norm_ns_ps += pnk;
+        pxk_old[i] = pxk;
+        pnk_old[i] = pnk;
+    }
+
+    return pnk_old[i];
+}
+
+/* mcra noise estimation */
+static inline double mcra_bin(noise_est_state_t *state, size_t i, real_t ns_ps, double SNRseg,
+                              double *norm_ns_ps) {
+    real_t *P = state->P;
+    real_t *P_min = state->P_min;
+    real_t *P_tmp = state->P_tmp;
+    real_t *pk = state->pk;
+    real_t *noise_ps_old = state->noise_ps_old;
+    const double ad = 0.95;
+    const double as = 0.8;
+    const int L = MCRA_WINDOW;
+    const int delta = 5;
+    const double ap = 0.2;
+    double Srk, adk;
+    int Ikl;
+
+    if (state->n == 0) {
+        P[i] = ns_ps;
+        P_min[i] = ns_ps;
+        P_tmp[i] = ns_ps;
+        noise_ps_old[i] = ns_ps;
+        *norm_ns_ps += P[i];
+        return noise_ps_old[i];
+    }
+
+    P[i] = as * P[i] + (1 - as) * ns_ps;
+
+    /* minimum is searched over windows of L frames */
+    if ((state->n + 1 + state->window_offset) % L == 0) {
+        P_min[i] = MIN (P_tmp[i], P[i]);
+        P_tmp[i] = P[i];
+    }
+    else {
+        P_min[i] = MIN (P_min[i], P[i]);
+        P_tmp[i] = MIN (P_tmp[i], P[i]);
+    }
+
+    Srk = check_nan(P[i] / P_min[i]);
+
+    Ikl = (Srk > delta) ? 1 : 0;
+
+    pk[i] = ap * pk[i] + (1 - ap) * Ikl;
+
+    adk = ad + (1 - ad) * pk[i];
+
+    noise_ps_old[i] = adk * noise_ps_old[i] + (1 - adk) * ns_ps;
+
+    *norm_ns_ps += noise_ps_old[i];
+    return noise_ps_old[i];
+}
+
+/* mcra 2  noise estimation */
+static inline double mcra2_bin(noise_est_state_t *state, size_t i, real_t ns_ps, double SNRseg,
+                               double *norm_ns_ps) {
+    real_t *noise_ps_old = state->noise_ps_old;
+    real_t *pxk_old = state->pxk_old;
+    real_t *pnk_old = state->pnk_old;
+    real_t *pk = state->pk;
+    real_t *delta = state->delta;
+    const double ad = 0.95;
+    const double ap = 0.2;
+    const double beta = 0.8;
+    const double gamma = 0.998;
+    const double alpha = 0.7;
+    double Srk, adk;
+    int Ikl;
+    double pxk, pnk;
+
+    if (state->n == 0) {
+        pxk_old[i] = ns_ps;
+        pnk_old[i] = ns_ps;
+        noise_ps_old[i] = ns_ps;
+
+        /* calculate delta */
+        if (i >= state->k_1khz && i < state->k_3khz)
+            delta[i] = 2;
+        else
+            delta[i] = 5;
+
+        *norm_ns_ps += noise_ps_old[i];
+        return noise_ps_old[i];
+    }
+
+    pxk = alpha * pxk_old[i] + (1 - alpha) * ns_ps;
+    if (pnk_old[i] <= pxk)
+        pnk = (gamma * pnk_old[i]) + (((1 - gamma) / (1 - beta)) * (pxk - beta * pxk_old[i]));
+    else
+        pnk = pxk;
+
+    *norm_ns_ps += pnk;
+    pxk_old[i] = pxk;
+    pnk_old[i] = pnk;
+
+    Srk = check_nan(pxk / pnk);
+    Ikl = (Srk > delta[i]) ? 1 : 0;
+    pk[i] = ap * pk[i] + (1 - ap) * Ikl;
+    adk = ad + (1 - ad) * pk[i];
+    noise_ps_old[i] = adk * noise_ps_old[i] + (1 - adk) * pxk;
+
+    return noise_ps_old[i];
+}
+
+#endif
@@ -0,0 +1,254 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "noise_profile.h"
+#include "i18n.h"
+
+/* header of profile file, integers are in byte order of writer, which is detected by byte_order */
+typedef struct noise_profile_header_t {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;                    /* NOISE_PROFILE_BYTE_ORDER as written by host */
+    char estimator[NOISE_PROFILE_NAME_LEN];
+    uint32_t samplerate;
+    uint32_t fft_size;
+    uint32_t channels;
+    uint32_t reserved;
+} noise_profile_header_t;
+
+/* state of one channel in file, followed by its arrays */
+typedef struct noise_profile_channel_t {
+    uint32_t frames;
+    uint32_t reserved;
+    double snr_seg;
+} noise_profile_channel_t;
+
+#define NOISE_PROFILE_BYTE_ORDER            0x01020304u
+
+/* arrays of noise estimation state in order of profile */
+static void state_arrays(const noise_est_state_t *state, real_t *arrays[NOISE_PROFILE_ARRAYS]);
+
+/* create empty profile of stream */
+setk_noise_profile_t *noise_profile_create(const char *estimator, int samplerate, size_t fft_size, int channels) {
+    setk_noise_profile_t *profile = (setk_noise_profile_t *) calloc(1, sizeof(*profile));
+
+    if (profile == NULL)
+        return NULL;
+
+    strncpy(profile->estimator, estimator, NOISE_PROFILE_NAME_LEN - 1);
+    profile->samplerate = samplerate;
+    profile->fft_size = fft_size;
+    profile->channels = channels;
+    profile->bins = fft_size / 2 + 1;
+
+    profile->arrays = (float *) calloc((size_t) channels * NOISE_PROFILE_ARRAYS * profile->bins,
+                                       sizeof(*profile->arrays));
+    profile->frames = (int *) calloc((size_t) channels, sizeof(*profile->frames));
+    profile->snr_seg = (double *) calloc((size_t) channels, sizeof(*profile->snr_seg));
+    if (profile->arrays == NULL || profile->frames == NULL || profile->snr_seg == NULL) {
+        noise_profile_destroy(profile);
+        return NULL;
+    }
+
+    return profile;
+}
+
+/* copy noise estimation state of context into channel ch of profile */
+void noise_profile_capture(setk_noise_profile_t *profile, int ch, const setk_context_t *ctx) {
+    float *dst = profile->arrays + (size_t) ch * NOISE_PROFILE_ARRAYS * profile->bins;
+    real_t *arrays[NOISE_PROFILE_ARRAYS];
+
+    state_arrays(&ctx->noise, arrays);
+    for (int a = 0; a < NOISE_PROFILE_ARRAYS; ++a) {
+        for (size_t i = 0; i < profile->bins; ++i)
+            *dst++ = (float) arrays[a][i];
+    }
+
+    profile->frames[ch] = ctx->noise.n;
+    profile->snr_seg[ch] = ctx->enh.SNRseg;
+}
+
+/* copy channel ch of profile into noise estimation state of context */
+void noise_profile_apply(const setk_noise_profile_t *profile, int ch, setk_context_t *ctx) {
+    const float *src;
+    real_t *arrays[NOISE_PROFILE_ARRAYS];
+
+    if (profile->channels == 1)
+        ch = 0;
+    src = profile->arrays + (size_t) ch * NOISE_PROFILE_ARRAYS * profile->bins;
+
+    state_arrays(&ctx->noise, arrays);
+    for (int a = 0; a < NOISE_PROFILE_ARRAYS; ++a) {
+        for (size_t i = 0; i < profile->bins; ++i)
+            arrays[a][i] = *src++;
+    }
+
+    /* estimators skip their initialization, which runs while n is 0 or small */
+    ctx->noise.n = profile->frames[ch];
+    ctx->enh.SNRseg = profile->snr_seg[ch];
+}
+
+/* check that profile matches stream */
+int noise_profile_check(const setk_noise_profile_t *profile, const char *estimator, int samplerate,
+                        size_t fft_size, int channels, bool verbose) {
+    if (strcmp(profile->estimator, estimator) != 0) {
+        if (verbose)
+            printf(_("Error: Noise profile was saved by '%s' noise estimation, not '%s'.\n"), profile->estimator,
+                   estimator);
+        return 1;
+    }
+    if (profile->samplerate != samplerate || profile->fft_size != fft_size) {
+        if (verbose)
+            printf(_("Error: Noise profile of %d Hz and FFT size %d does not match %d Hz and FFT size %d.\n"),
+                   profile->samplerate, (int) profile->fft_size, samplerate, (int) fft_size);
+        return 1;
+    }
+    if (profile->channels != 1 && profile->channels != channels) {
+        if (verbose)
+            printf(_("Error: Noise profile of %d channels does not match %d channels.\n"), profile->channels,
+                   channels);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* save profile into file */
+int noise_profile_save(const setk_noise_profile_t *profile, const char *filename, bool verbose) {
+    noise_profile_header_t header;
+    noise_profile_channel_t channel;
+    size_t values = NOISE_PROFILE_ARRAYS * profile->bins;
+    FILE *file;
+    int status = 0;
+
+    memset((void *) &header, 0, sizeof(header));
+    memcpy(header.magic, NOISE_PROFILE_MAGIC, sizeof(header.magic));
+    header.version = NOISE_PROFILE_VERSION;
+    header.byte_order = NOISE_PROFILE_BYTE_ORDER;
+    memcpy(header.estimator, profile->estimator, sizeof(header.estimator));
+    header.samplerate = (uint32_t) profile->samplerate;
+    header.fft_size = (uint32_t) profile->fft_size;
+    header.channels = (uint32_t) profile->channels;
+
+    if ((file = fopen(filename, "wb")) == NULL) {
+        if (verbose)
+            printf(_("Error: Unable to open noise profile '%s': %s\n"), filename, strerror(errno));
+        return 1;
+    }
+
+    fwrite(&header, sizeof(header), 1, file);
+    for (int ch = 0; ch < profile->channels; ++ch) {
+        memset((void *) &channel, 0, sizeof(channel));
+        channel.frames = (uint32_t) profile->frames[ch];
+        channel.snr_seg = profile->snr_seg[ch];
+
+        fwrite(&channel, sizeof(channel), 1, file);
+        fwrite(profile->arrays + ch * values, sizeof(*profile->arrays), values, file);
+    }
+
+    if (ferror(file))
+        status = 1;
+    if (fclose(file) != 0)
+        status = 1;
+    if (status != 0 && verbose)
+        printf(_("Error: Unable to write noise profile '%s': %s\n"), filename, strerror(errno));
+
+    return status;
+}
+
+/* load profile from file */
+setk_noise_profile_t *noise_profile_load(const char *filename, bool verbose) {
+    noise_profile_header_t header;
+    noise_profile_channel_t channel;
+    setk_noise_profile_t *profile;
+    size_t values;
+    FILE *file;
+
+    if ((file = fopen(filename, "rb")) == NULL) {
+        if (verbose)
+            printf(_("Error: Unable to open noise profile '%s': %s\n"), filename, strerror(errno));
+        return NULL;
+    }
+
+    /* fields are checked before they size any allocation */
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, NOISE_PROFILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != NOISE_PROFILE_VERSION || header.byte_order != NOISE_PROFILE_BYTE_ORDER ||
+        header.estimator[NOISE_PROFILE_NAME_LEN - 1] != '\0' || header.channels == 0 ||
+        header.channels > NOISE_PROFILE_CHANNELS_MAX || header.fft_size == 0 || header.fft_size > FFT_MAX) {
+        if (verbose)
+            printf(_("Error: '%s' is not a noise profile of this version.\n"), filename);
+        fclose(file);
+        return NULL;
+    }
+
+    if ((profile = noise_profile_create(header.estimator, (int) header.samplerate, header.fft_size,
+                                        (int) header.channels)) == NULL) {
+        if (verbose)
+            printf(_("Error: Unable to allocate noise profile '%s'.\n"), filename);
+        fclose(file);
+        return NULL;
+    }
+    values = NOISE_PROFILE_ARRAYS * profile->bins;
+
+    for (int ch = 0; ch < profile->channels; ++ch) {
+        if (fread(&channel, sizeof(channel), 1, file) != 1 ||
+            fread(profile->arrays + ch * values, sizeof(*profile->arrays), values, file) != values) {
+            if (verbose)
+                printf(_("Error: Noise profile '%s' is truncated.\n"), filename);
+            noise_profile_destroy(profile);
+            fclose(file);
+            return NULL;
+        }
+
+        profile->frames[ch] = (int) MIN(channel.frames, (uint32_t) INT_MAX);
+        profile->snr_seg[ch] = channel.snr_seg;
+    }
+
+    fclose(file);
+
+    return profile;
+}
+
+/* free profile */
+void noise_profile_destroy(setk_noise_profile_t *profile) {
+    if (profile == NULL)
+        return;
+
+    free(profile->arrays);
+    free(profile->frames);
+    free(profile->snr_seg);
+    free(profile);
+}
+
+/* arrays of noise estimation state in order of profile */
+static void state_arrays(const noise_est_state_t *state, real_t *arrays[NOISE_PROFILE_ARRAYS]) {
+    arrays[0] = state->P;
+    arrays[1] = state->P_min;
+    arrays[2] = state->P_tmp;
+    arrays[3] = state->pk;
+    arrays[4] = state->pxk_old;
+    arrays[5] = state->pnk_old;
+    arrays[6] = state->delta;
+    arrays[7] = state->noise_ps_old;
+}
@@ -0,0 +1,63 @@
+/********************************************************************
+ function: Noise Profile
+ contains: converged state of noise estimation of every channel, which
+           is saved into a compact binary file and loaded as initial
+           state of other streams, e.g. recordings of the same line
+ ********************************************************************/
+
+#ifndef HAVE_NOISE_PROFILE_H
+#define HAVE_NOISE_PROFILE_H
+
+#include "common.h"
+#include "context.h"
+
+/* file starts with magic and version, header is followed by state of every channel */
+#define NOISE_PROFILE_MAGIC                 "SETKNOIS"
+#define NOISE_PROFILE_VERSION               1
+
+/* arrays of noise_est_state_t, which are saved in this order */
+#define NOISE_PROFILE_ARRAYS                8
+
+/* most channels of profile */
+#define NOISE_PROFILE_CHANNELS_MAX          256
+
+/* longest name of noise estimation algorithm */
+#define NOISE_PROFILE_NAME_LEN              16
+
+/* state of noise estimation of channels, arrays hold NOISE_PROFILE_ARRAYS * bins values per channel */
+typedef struct setk_noise_profile_t {
+    char estimator[NOISE_PROFILE_NAME_LEN]; /* name of noise estimation algorithm, e.g. "mcra" */
+    int samplerate;
+    size_t fft_size;
+    int channels;
+    size_t bins;                            /* fft_size / 2 + 1 */
+    float *arrays;                          /* stored in single precision, so that profile is compact */
+    int *frames;                            /* frames estimated by every channel, state->n */
+    double *snr_seg;                        /* segmental SNR of last frame of every channel */
+} setk_noise_profile_t;
+
+/* create empty profile of stream, NULL when it cannot be allocated */
+extern setk_noise_profile_t *noise_profile_create(const char *estimator, int samplerate, size_t fft_size,
+                                                  int channels);
+
+/* copy noise estimation state of context into channel ch of profile */
+extern void noise_profile_capture(setk_noise_profile_t *profile, int ch, const setk_context_t *ctx);
+
+/* copy channel ch of profile into noise estimation state of context, mono profile is used for all channels */
+extern void noise_profile_apply(const setk_noise_profile_t *profile, int ch, setk_context_t *ctx);
+
+/* check that profile was saved from stream of the same estimator, samplerate, FFT size and channels,
+ * or from mono stream, returns 1 when it does not match, error is printed in verbose mode */
+extern int noise_profile_check(const setk_noise_profile_t *profile, const char *estimator, int samplerate,
+                               size_t fft_size, int channels, bool verbose);
+
+/* save profile into file, returns 0 on success, error is printed in verbose mode */
+extern int noise_profile_save(const setk_noise_profile_t *profile, const char *filename, bool verbose);
+
+/* load profile from file, returns NULL when it cannot be read, error is printed in verbose mode */
+extern setk_noise_profile_t *noise_profile_load(const char *filename, bool verbose);
+
+/* free profile */
+extern void noise_profile_destroy(setk_noise_profile_t *profile);
+
+#endif
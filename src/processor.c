@@ -0,0 +1,337 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "processor.h"
+#include "i18n.h"
+
+/* process one channel of current frame */
+static void process_channel(setk_processor_t *proc, int ch);
+
+/* channel thread */
+static void *channel_worker(void *arg);
+
+/* create frame processor, partial processor is destroyed on error */
+setk_status_t processor_create(setk_processor_t **processor, size_t fft_size, size_t window_size, int overlap,
+                               int channels, int samplerate, window_func_t window_function,
+                               snd_enh_func_t sound_enhancement, noise_est_func_t noise_estimation,
+                               fft_plan_t fft_forw, fft_plan_t fft_back, int nthreads) {
+    setk_processor_t *proc = (setk_processor_t *) calloc(1, sizeof(*proc));
+
+    *processor = NULL;
+    if (proc == NULL)
+        return SETK_ERROR_MEMORY;
+
+    proc->fft_size = fft_size;
+    proc->window_size = window_size;
+    proc->overlap = overlap;
+    proc->noverlap = (int) floor(window_size * overlap / 100);
+    proc->nslide = (int) window_size - proc->noverlap;
+    proc->channels = channels;
+    proc->samplerate = samplerate;
+    proc->window_function = window_function;
+    proc->sound_enhancement = sound_enhancement;
+    proc->noise_estimation = noise_estimation;
+    proc->fft_forw = fft_forw;
+    proc->fft_back = fft_back;
+
+    /* every channel has its own FFT buffer, window, noise estimation and sound enhancement state */
+    proc->contexts = (setk_context_t **) calloc((size_t) channels, sizeof(*proc->contexts));
+    proc->es_old_multi = init_buffer_real((size_t) proc->nslide * channels);
+    if (proc->contexts == NULL || proc->es_old_multi == NULL) {
+        processor_destroy(proc);
+        return SETK_ERROR_MEMORY;
+    }
+
+    for (int ch = 0; ch < channels; ++ch) {
+        if ((proc->contexts[ch] = setk_context_create(fft_size, window_size, samplerate, window_function)) == NULL) {
+            processor_destroy(proc);
+            return SETK_ERROR_MEMORY;
+        }
+    }
+
+    /* there is no use for more threads than channels */
+    proc->nthreads = MAX (1, MIN (nthreads, channels));
+    proc->quit = false;
+
+    if (proc->nthreads > 1) {
+        proc->threads = (pthread_t *) malloc(sizeof(*proc->threads) * proc->nthreads);
+        proc->workers = (processor_worker_t *) malloc(sizeof(*proc->workers) * proc->nthreads);
+        if (proc->threads == NULL || proc->workers == NULL) {
+            processor_destroy(proc);
+            return SETK_ERROR_MEMORY;
+        }
+
+        for (int t = 0; t < proc->nthreads; ++t) {
+            proc->workers[t].proc = proc;
+            proc->workers[t].index = t;
+        }
+
+        /* worker 0 is run by the caller of processor_run(), threads wait for barriers until all of them
+         * were created, when one of them cannot be created, the others quit at their first barrier */
+        pthread_mutex_init(&proc->start_lock, NULL);
+        pthread_mutex_lock(&proc->start_lock);
+
+        while (proc->started < proc->nthreads - 1 &&
+               pthread_create(&proc->threads[proc->started + 1], NULL, channel_worker,
+                              &proc->workers[proc->started + 1]) == 0)
+            proc->started++;
+
+        proc->quit = (proc->started < proc->nthreads - 1);
+        pthread_barrier_init(&proc->hop_start, NULL, (unsigned) proc->started + 1);
+        pthread_barrier_init(&proc->hop_done, NULL, (unsigned) proc->started + 1);
+        proc->running = true;
+
+        pthread_mutex_unlock(&proc->start_lock);
+
+        if (proc->quit) {
+            processor_destroy(proc);
+            return SETK_ERROR_THREAD;
+        }
+    }
+
+    *processor = proc;
+
+    return SETK_OK;
+}
+
+/* enhance window_size interleaved frames of multi_data */
+void processor_run(setk_processor_t *proc, real_t *multi_data) {
+    proc->multi_data = multi_data;
+
+    if (proc->nthreads == 1) {
+        for (int ch = 0; ch < proc->channels; ++ch)
+            process_channel(proc, ch);
+        return;
+    }
+
+    /* channels are rejoined in multi_data before both barriers are passed */
+    pthread_barrier_wait(&proc->hop_start);
+    for (int ch = 0; ch < proc->channels; ch += proc->nthreads)
+        process_channel(proc, ch);
+    pthread_barrier_wait(&proc->hop_done);
+}
+
+/* create processor of the same configuration in initial state */
+setk_processor_t *processor_clone(const setk_processor_t *proc) {
+    setk_processor_t *clone;
+
+    if (processor_create(&clone, proc->fft_size, proc->window_size, proc->overlap, proc->channels,
+                         proc->samplerate, proc->window_function, proc->sound_enhancement, proc->noise_estimation,
+                         proc->fft_forw, proc->fft_back, proc->nthreads) != SETK_OK)
+        return NULL;
+
+    if (proc->contexts[0]->profile != NULL)
+        processor_enable_profile(clone);
+
+    if (proc->noise_profile != NULL)
+        processor_set_noise_profile(clone, proc->noise_profile);
+
+    return clone;
+}
+
+/* estimate noise of window_size interleaved frames of multi_data into hop of track */
+void processor_estimate(setk_processor_t *proc, real_t *multi_data, setk_track_t *track, sf_count_t hop) {
+    for (int ch = 0; ch < proc->channels; ++ch) {
+        setk_context_t *ctx = proc->contexts[ch];
+        real_t *fft_data = ctx->fft_data;
+        uint64_t t = PROFILE_BEGIN(ctx->profile); /* start of profiled stage */
+
+        memset(fft_data, 0, sizeof(*fft_data) * (proc->fft_size));
+        separate_channels_real(multi_data, fft_data, (int) proc->window_size, proc->channels, ch);
+        PROFILE_END(ctx->profile, PROFILE_SEPARATE, t);
+
+        apply_window(fft_data, ctx->window, proc->window_size);
+        PROFILE_END(ctx->profile, PROFILE_WINDOW, t);
+
+        *track_norm_ns_ps(track, hop, ch) = snd_enhance_estimate(ctx, fft_data, proc->fft_size, proc->fft_forw,
+                                                                 proc->noise_estimation, proc->samplerate,
+                                                                 track_noise_ps(track, hop, ch));
+    }
+}
+
+/* take noise of next frames from hop of track */
+void processor_use_track(setk_processor_t *proc, const setk_track_t *track, sf_count_t hop) {
+    for (int ch = 0; ch < proc->channels; ++ch) {
+        proc->contexts[ch]->track_noise_ps = (track != NULL) ? track_noise_ps(track, hop, ch) : NULL;
+        proc->contexts[ch]->track_norm_ns_ps = (track != NULL) ? *track_norm_ns_ps(track, hop, ch) : 0.0;
+    }
+}
+
+/* start noise estimation of every channel from profile */
+void processor_set_noise_profile(setk_processor_t *proc, const setk_noise_profile_t *profile) {
+    proc->noise_profile = profile;
+
+    for (int ch = 0; ch < proc->channels; ++ch)
+        noise_profile_apply(profile, ch, proc->contexts[ch]);
+}
+
+/* copy noise estimation state of every channel into profile */
+void processor_capture_noise_profile(const setk_processor_t *proc, setk_noise_profile_t *profile) {
+    for (int ch = 0; ch < proc->channels; ++ch)
+        noise_profile_capture(profile, ch, proc->contexts[ch]);
+}
+
+/* return processor to its initial state, noise estimation starts from profile if it was set */
+void processor_reset(setk_processor_t *proc) {
+    for (int ch = 0; ch < proc->channels; ++ch) {
+        setk_context_reset(proc->contexts[ch]);
+        if (proc->noise_profile != NULL)
+            noise_profile_apply(proc->noise_profile, ch, proc->contexts[ch]);
+    }
+
+    memset((void *) proc->es_old_multi, 0, sizeof(*proc->es_old_multi) * proc->nslide * proc->channels);
+}
+
+/* start timing of stages in every channel */
+void processor_enable_profile(setk_processor_t *proc) {
+    for (int ch = 0; ch < proc->channels; ++ch) {
+        if (proc->contexts[ch]->profile == NULL)
+            proc->contexts[ch]->profile = profile_create();
+    }
+}
+
+/* add stage timing of all channels to profile */
+void processor_collect_profile(const setk_processor_t *proc, setk_profile_t *profile) {
+    for (int ch = 0; ch < proc->channels; ++ch) {
+        if (proc->contexts[ch]->profile != NULL)
+            profile_merge(profile, proc->contexts[ch]->profile);
+    }
+}
+
+/* mean segmental SNR of channel over all processed frames */
+double processor_mean_snr_seg(const setk_processor_t *proc, int ch) {
+    const setk_context_t *ctx = proc->contexts[ch];
+
+    return ctx->frames > 0 ? ctx->snr_seg_sum / ctx->frames : 0.0;
+}
+
+/* align windows of minimum search of mcra with one pass, which starts at hop 0 */
+void processor_set_first_hop(setk_processor_t *proc, sf_count_t hop) {
+    for (int ch = 0; ch < proc->channels; ++ch)
+        proc->contexts[ch]->noise.window_offset = (int) (hop % MCRA_WINDOW);
+}
+
+/* clear segmental SNR of all channels */
+void processor_clear_snr_seg(setk_processor_t *proc) {
+    for (int ch = 0; ch < proc->channels; ++ch) {
+        proc->contexts[ch]->snr_seg_sum = 0.0;
+        proc->contexts[ch]->frames = 0;
+    }
+}
+
+/* add segmental SNR of frames of src to dst */
+void processor_merge_snr_seg(setk_processor_t *dst, const setk_processor_t *src) {
+    for (int ch = 0; ch < dst->channels; ++ch) {
+        dst->contexts[ch]->snr_seg_sum += src->contexts[ch]->snr_seg_sum;
+        dst->contexts[ch]->frames += src->contexts[ch]->frames;
+    }
+}
+
+/* stop channel threads and free processor */
+void processor_destroy(setk_processor_t *proc) {
+    if (proc == NULL)
+        return;
+
+    if (proc->running) {
+        proc->quit = true;
+        pthread_barrier_wait(&proc->hop_start);
+
+        for (int t = 1; t <= proc->started; ++t)
+            pthread_join(proc->threads[t], NULL);
+
+        pthread_barrier_destroy(&proc->hop_start);
+        pthread_barrier_destroy(&proc->hop_done);
+        pthread_mutex_destroy(&proc->start_lock);
+    }
+    free(proc->threads);
+    free(proc->workers);
+
+    /* contexts are NULL after their allocation failed */
+    for (int ch = 0; proc->contexts != NULL && ch < proc->channels; ++ch)
+        setk_context_destroy(proc->contexts[ch]);
+
+    free(proc->contexts);
+    free(proc->es_old_multi);
+    free(proc);
+}
+
+/* process one channel of current frame */
+static void process_channel(setk_processor_t *proc, int ch) {
+    setk_context_t *ctx = proc->contexts[ch];
+    real_t *fft_data = ctx->fft_data;
+    real_t *es_old = proc->es_old_multi + ch * proc->nslide;
+    double winGain;
+    uint64_t t = PROFILE_BEGIN(ctx->profile); /* start of profiled stage */
+
+    memset(fft_data, 0, sizeof(*fft_data) * (proc->fft_size)); /* initialize fft array to zero values */
+
+    separate_channels_real(proc->multi_data, fft_data, (int) proc->window_size, proc->channels, ch);
+    PROFILE_END(ctx->profile, PROFILE_SEPARATE, t);
+
+    apply_window(fft_data, ctx->window, proc->window_size);
+    winGain = proc->nslide / ctx->win_gain;
+    PROFILE_END(ctx->profile, PROFILE_WINDOW, t);
+
+    /* FFT, noise estimation, gain and IFFT are profiled by sound enhancement */
+    proc->sound_enhancement(ctx, fft_data, proc->fft_size, proc->fft_forw, proc->fft_back, proc->noise_estimation,
+                            proc->window_size, proc->samplerate);
+    t = PROFILE_BEGIN(ctx->profile);
+
+    ctx->snr_seg_sum += ctx->enh.SNRseg;
+    ctx->frames++;
+
+    /* Add-and-Overlap */
+    for (int i = 0; i < proc->nslide; ++i) {
+        fft_data[i] = winGain * (fft_data[i] / (proc->fft_size) + es_old[i]);
+    }
+
+    for (int i = 0; i < proc->nslide; ++i) {
+        es_old[i] = fft_data[i + proc->noverlap] / (proc->fft_size);
+    }
+    PROFILE_END(ctx->profile, PROFILE_OVERLAP_ADD, t);
+
+    combine_channels_real(proc->multi_data, fft_data, proc->nslide, proc->channels, ch);
+    PROFILE_END(ctx->profile, PROFILE_COMBINE, t);
+}
+
+/* channel thread */
+static void *channel_worker(void *arg) {
+    processor_worker_t *worker = (processor_worker_t *) arg;
+    setk_processor_t *proc = worker->proc;
+
+    /* barriers are initialized once all threads were created */
+    pthread_mutex_lock(&proc->start_lock);
+    pthread_mutex_unlock(&proc->start_lock);
+
+    for (;;) {
+        pthread_barrier_wait(&proc->hop_start);
+        if (proc->quit)
+            break;
+
+        for (int ch = worker->index; ch < proc->channels; ch += proc->nthreads)
+            process_channel(proc, ch);
+
+        pthread_barrier_wait(&proc->hop_done);
+    }
+
+    return NULL;
+}
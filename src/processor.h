@@ -0,0 +1,117 @@
+/********************************************************************
+ function: Frame Processor
+ contains: window -> sound enhancement -> overlap-add loop over all
+           channels of one audio stream, optionally one thread per
+           group of channels
+ ********************************************************************/
+
+#ifndef HAVE_PROCESSOR_H
+#define HAVE_PROCESSOR_H
+
+#include <pthread.h>
+#include "setk.h"
+#include "fft.h"
+#include "common.h"
+#include "context.h"
+#include "snd_enhance.h"
+#include "window.h"
+#include "track.h"
+#include "noise_profile.h"
+
+/* maximum number of channel threads */
+#define CHANNEL_THREADS_MAX                 64
+
+struct setk_processor_t;
+
+/* argument of channel thread */
+typedef struct processor_worker_t {
+    struct setk_processor_t *proc;
+    int index;                              /* channels index, index + nthreads, ... are processed */
+} processor_worker_t;
+
+typedef struct setk_processor_t {
+    size_t fft_size;
+    size_t window_size;
+    int overlap;                            /* overlap of adjacent frames in percent */
+    int noverlap;                           /* overlapping samples of adjacent frames */
+    int nslide;                             /* samples of new data in each frame */
+    int channels;
+    int samplerate;
+    window_func_t window_function;
+    snd_enh_func_t sound_enhancement;
+    noise_est_func_t noise_estimation;
+    fft_plan_t fft_forw;                     /* plans are only executed with new-array */
+    fft_plan_t fft_back;                     /* execute on private buffers of contexts */
+    setk_context_t **contexts;              /* one context per channel */
+    const setk_noise_profile_t *noise_profile; /* initial state of noise estimation, or NULL */
+    real_t *es_old_multi;                   /* overlap-add tail of previous frame */
+    real_t *multi_data;                     /* interleaved frame which is being processed */
+
+    /* channel threads, main thread processes channels of worker 0 */
+    int nthreads;
+    int started;                            /* channel threads which were created */
+    bool running;                           /* barriers are initialized for started threads and main thread */
+    pthread_t *threads;
+    processor_worker_t *workers;
+    pthread_mutex_t start_lock;             /* held until barriers are initialized */
+    pthread_barrier_t hop_start;
+    pthread_barrier_t hop_done;
+    bool quit;
+} setk_processor_t;
+
+/* create frame processor, plans must be created for fftw_alloc_real() aligned buffers of fft_size,
+ * returns SETK_ERROR_MEMORY or SETK_ERROR_THREAD when it cannot be created, *proc is NULL on error */
+extern setk_status_t processor_create(setk_processor_t **proc, size_t fft_size, size_t window_size, int overlap,
+                                      int channels, int samplerate, window_func_t window_function,
+                                      snd_enh_func_t sound_enhancement, noise_est_func_t noise_estimation,
+                                      fft_plan_t fft_forw, fft_plan_t fft_back, int nthreads);
+
+/* enhance window_size interleaved frames of multi_data, first nslide frames are replaced with output */
+extern void processor_run(setk_processor_t *proc, real_t *multi_data);
+
+/* create processor of the same configuration in initial state, e.g. for another segment of stream,
+ * timing is enabled if it is enabled in proc, noise profile is shared, NULL when it cannot be created */
+extern setk_processor_t *processor_clone(const setk_processor_t *proc);
+
+/* estimate noise of window_size interleaved frames of multi_data into hop of track, multi_data is kept,
+ * e.g. first pass of two-pass mode, all channels are estimated on calling thread */
+extern void processor_estimate(setk_processor_t *proc, real_t *multi_data, setk_track_t *track,
+                               sf_count_t hop);
+
+/* take noise of next frames from hop of track instead of estimating it, NULL track estimates noise again */
+extern void processor_use_track(setk_processor_t *proc, const setk_track_t *track, sf_count_t hop);
+
+/* start noise estimation of every channel from profile, which is used as initial state until processor
+ * is destroyed, profile must match processor, see noise_profile_check() */
+extern void processor_set_noise_profile(setk_processor_t *proc, const setk_noise_profile_t *profile);
+
+/* copy noise estimation state of every channel into profile of the same channels */
+extern void processor_capture_noise_profile(const setk_processor_t *proc, setk_noise_profile_t *profile);
+
+/* return processor to its initial state, e.g. before processing next stream */
+extern void processor_reset(setk_processor_t *proc);
+
+/* time stages of every channel, e.g. for --profile, timing stays enabled until processor is destroyed,
+ * channel is not timed when its profile cannot be allocated */
+extern void processor_enable_profile(setk_processor_t *proc);
+
+/* add stage timing of all channels to profile */
+extern void processor_collect_profile(const setk_processor_t *proc, setk_profile_t *profile);
+
+/* mean segmental SNR in dB of channel over all frames processed since create, reset or clear */
+extern double processor_mean_snr_seg(const setk_processor_t *proc, int ch);
+
+/* align windows of minimum search of mcra with one pass of file, which starts at hop 0,
+ * when processing starts at hop, initialization of noise estimation still runs at the first frame */
+extern void processor_set_first_hop(setk_processor_t *proc, sf_count_t hop);
+
+/* clear segmental SNR of all channels, state of algorithms is kept, e.g. after warm-up frames */
+extern void processor_clear_snr_seg(setk_processor_t *proc);
+
+/* add segmental SNR of frames of src to dst, which has the same channels */
+extern void processor_merge_snr_seg(setk_processor_t *dst, const setk_processor_t *src);
+
+/* stop channel threads and free processor */
+extern void processor_destroy(setk_processor_t *proc);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include "profile.h"
+#include "i18n.h"
+
+static const char *profile_stage_names[PROFILE_STAGES] = {
+        "read",
+        "separate channels",
+        "window",
+        "fft forward",
+        "noise estimation",
+        "gain",
+        "fft backward",
+        "overlap-add",
+        "combine channels",
+        "write",
+        "hop",
+};
+
+/* duration at quantile q of stage, geometric middle of histogram bucket */
+static double profile_quantile(const profile_stats_t *stats, double q);
+
+/* create empty profile */
+setk_profile_t *profile_create(void) {
+    setk_profile_t *profile = (setk_profile_t *) calloc(1, sizeof(*profile));
+
+    return profile;
+}
+
+/* add durations of src to dst */
+void profile_merge(setk_profile_t *dst, const setk_profile_t *src) {
+    for (int s = 0; s < PROFILE_STAGES; ++s) {
+        profile_stats_t *d = &dst->stages[s];
+        const profile_stats_t *from = &src->stages[s];
+
+        d->total += from->total;
+        d->count += from->count;
+        d->max = MAX(d->max, from->max);
+        for (int b = 0; b < PROFILE_BUCKETS; ++b)
+            d->histogram[b] += from->histogram[b];
+    }
+}
+
+/* print report of all stages */
+void profile_report(const setk_profile_t *profile, double hop_duration) {
+    const profile_stats_t *hop = &profile->stages[PROFILE_HOP];
+    uint64_t total = 0;
+
+    /* hop covers the other stages */
+    for (int s = 0; s < PROFILE_HOP; ++s)
+        total += profile->stages[s].total;
+
+    printf(_("\n-----------------------------------------\n"));
+    printf(_("P R O F I L E :\n"));
+    printf(_("-----------------------------------------\n"));
+    printf(_("%-18s %10s %6s %10s %10s %10s %10s %10s\n"), _("stage"), _("total ms"), "%", _("count"),
+           _("mean us"), _("p50 us"), _("p99 us"), _("max us"));
+
+    for (int s = 0; s < PROFILE_STAGES; ++s) {
+        const profile_stats_t *stats = &profile->stages[s];
+
+        if (stats->count == 0)
+            continue;
+
+        /* share of time of all stages, hop is their sum in wall clock time */
+        printf("%-18s %10.3f ", profile_stage_names[s], stats->total / 1e6);
+        if (s != PROFILE_HOP && total > 0)
+            printf("%6.1f ", 100.0 * stats->total / total);
+        else
+            printf("%6s ", "-");
+        printf("%10lu %10.2f %10.2f %10.2f %10.2f\n", (unsigned long) stats->count, stats->total / 1e3 / stats->count,
+               profile_quantile(stats, 0.5) / 1e3, profile_quantile(stats, 0.99) / 1e3, stats->max / 1e3);
+    }
+
+    /* share of hop duration which is left for other work, negative headroom means hops are late */
+    if (hop->count > 0 && hop_duration > 0) {
+        double hop_ns = hop_duration * 1e9;
+
+        printf(_("-----------------------------------------\n"));
+        printf(_("Real-time headroom per hop of %.2f ms: mean %.1f %%, p50 %.1f %%, p99 %.1f %%, worst %.1f %%\n"),
+               hop_duration * 1e3, 100.0 * (1.0 - (double) hop->total / hop->count / hop_ns),
+               100.0 * (1.0 - profile_quantile(hop, 0.5) / hop_ns), 100.0 * (1.0 - profile_quantile(hop, 0.99) / hop_ns),
+               100.0 * (1.0 - hop->max / hop_ns));
+    }
+    printf(_("-----------------------------------------\n"));
+}
+
+/* free profile */
+void profile_destroy(setk_profile_t *profile) {
+    free(profile);
+}
+
+/* duration at quantile q of stage, geometric middle of histogram bucket */
+static double profile_quantile(const profile_stats_t *stats, double q) {
+    uint64_t rank = (uint64_t) ceil(q * stats->count);
+    uint64_t seen = 0;
+
+    for (int b = 0; b < PROFILE_BUCKETS; ++b) {
+        seen += stats->histogram[b];
+        if (seen < rank || stats->histogram[b] == 0)
+            continue;
+
+        if (b < PROFILE_SUBBUCKETS)
+            return b;
+
+        /* bucket covers <lower, lower + width) */
+        int octave = b / PROFILE_SUBBUCKETS + 2;
+        double width = ldexp(1.0, octave - 3);
+        double lower = (PROFILE_SUBBUCKETS + b % PROFILE_SUBBUCKETS) * width;
+
+        return MIN(sqrt(lower * (lower + width)), (double) stats->max);
+    }
+
+    return (double) stats->max;
+}
@@ -0,0 +1,103 @@
+/********************************************************************
+ function: Profiling
+ contains: per-stage timing of frame processing, durations are kept
+           in logarithmic histograms for percentiles
+ ********************************************************************/
+
+#ifndef HAVE_PROFILE_H
+#define HAVE_PROFILE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "common.h"
+
+/* histogram of durations in nanoseconds has PROFILE_SUBBUCKETS buckets per octave,
+ * so percentiles are accurate within 1 / PROFILE_SUBBUCKETS */
+#define PROFILE_SUBBUCKETS                  8
+#define PROFILE_OCTAVES                     40
+#define PROFILE_BUCKETS                     (PROFILE_SUBBUCKETS * PROFILE_OCTAVES)
+
+/* profiled stages, channel stages are timed once per channel and frame, the rest once per hop */
+typedef enum profile_stage_t {
+    PROFILE_READ,
+    PROFILE_SEPARATE,
+    PROFILE_WINDOW,
+    PROFILE_FFT_FORW,
+    PROFILE_NOISE_EST,
+    PROFILE_GAIN,
+    PROFILE_FFT_BACK,
+    PROFILE_OVERLAP_ADD,
+    PROFILE_COMBINE,
+    PROFILE_WRITE,
+    PROFILE_HOP,
+    PROFILE_STAGES
+} profile_stage_t;
+
+/* durations of one stage in nanoseconds */
+typedef struct profile_stats_t {
+    uint64_t total;
+    uint64_t count;
+    uint64_t max;
+    uint32_t histogram[PROFILE_BUCKETS];
+} profile_stats_t;
+
+typedef struct setk_profile_t {
+    profile_stats_t stages[PROFILE_STAGES];
+} setk_profile_t;
+
+/* monotonic clock in nanoseconds */
+static inline uint64_t profile_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+/* histogram bucket of duration */
+static inline int profile_bucket(uint64_t ns) {
+    int octave;
+
+    if (ns < PROFILE_SUBBUCKETS)
+        return (int) ns;
+
+    /* octave of most significant bit, next three bits select sub-bucket */
+    octave = 63 - __builtin_clzll(ns);
+    return MIN((octave - 2) * PROFILE_SUBBUCKETS + (int) ((ns >> (octave - 3)) & (PROFILE_SUBBUCKETS - 1)),
+               PROFILE_BUCKETS - 1);
+}
+
+/* record stage which started at start, returns current time as start of next stage */
+static inline uint64_t profile_add(setk_profile_t *profile, profile_stage_t stage, uint64_t start) {
+    uint64_t now = profile_clock();
+    uint64_t ns = now - start;
+    profile_stats_t *stats = &profile->stages[stage];
+
+    stats->total += ns;
+    stats->count++;
+    if (ns > stats->max)
+        stats->max = ns;
+    stats->histogram[profile_bucket(ns)]++;
+
+    return now;
+}
+
+/* start of profiled stage, clock is not read when profiling is off, e.g. profile is NULL */
+#define PROFILE_BEGIN(profile)              ((profile) != NULL ? profile_clock() : 0)
+
+/* end of profiled stage, start is moved to its end, so stages may be chained */
+#define PROFILE_END(profile, stage, start) \
+    do { if ((profile) != NULL) (start) = profile_add((profile), (stage), (start)); } while (0)
+
+/* create empty profile, NULL when it cannot be allocated */
+extern setk_profile_t *profile_create(void);
+
+/* add durations of src to dst, e.g. profiles of channels */
+extern void profile_merge(setk_profile_t *dst, const setk_profile_t *src);
+
+/* print totals, mean, p50, p99 and max of every stage, and real-time headroom of hops of hop_duration seconds */
+extern void profile_report(const setk_profile_t *profile, double hop_duration);
+
+/* free profile */
+extern void profile_destroy(setk_profile_t *profile);
+
+#endif
@@ -0,0 +1,94 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "queue.h"
+#include "i18n.h"
+
+/* initialize empty queue */
+int queue_init(setk_queue_t *queue, int capacity) {
+    queue->capacity = capacity;
+    queue->head = 0;
+    queue->count = 0;
+    queue->closed = false;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+
+    queue->items = (void **) malloc(sizeof(*queue->items) * capacity);
+
+    return queue->items != NULL ? 0 : 1;
+}
+
+/* append item, waits while queue is full */
+int queue_push(setk_queue_t *queue, void *item) {
+    int status = 0;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->capacity && !queue->closed)
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+
+    if (queue->closed)
+        status = -1;
+    else {
+        queue->items[(queue->head + queue->count) % queue->capacity] = item;
+        queue->count++;
+        pthread_cond_signal(&queue->not_empty);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return status;
+}
+
+/* remove oldest item, waits while queue is empty */
+void *queue_pop(setk_queue_t *queue) {
+    void *item = NULL;
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->closed)
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+
+    if (queue->count > 0) {
+        item = queue->items[queue->head];
+        queue->head = (queue->head + 1) % queue->capacity;
+        queue->count--;
+        pthread_cond_signal(&queue->not_full);
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return item;
+}
+
+/* close queue and wake both threads */
+void queue_close(setk_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->closed = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_cond_broadcast(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+/* free queue */
+void queue_destroy(setk_queue_t *queue) {
+    pthread_cond_destroy(&queue->not_full);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+}
@@ -0,0 +1,42 @@
+/********************************************************************
+ function: Bounded queue
+ contains: blocking queue of pointers between one producer and one
+           consumer thread, e.g. blocks of audio between reader and
+           frame processing
+ ********************************************************************/
+
+#ifndef HAVE_QUEUE_H
+#define HAVE_QUEUE_H
+
+#include <pthread.h>
+#include "common.h"
+
+/* producer waits while queue is full, so it never runs ahead of consumer by more than capacity items */
+typedef struct setk_queue_t {
+    void **items;
+    int capacity;
+    int head;                               /* index of oldest item */
+    int count;
+    bool closed;                            /* no more items are pushed, waiting threads are woken */
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+} setk_queue_t;
+
+/* initialize empty queue of capacity items, returns 0 on success, queue is destroyed
+ * by queue_destroy() in both cases */
+extern int queue_init(setk_queue_t *queue, int capacity);
+
+/* append item, waits while queue is full, returns -1 when queue was closed */
+extern int queue_push(setk_queue_t *queue, void *item);
+
+/* remove oldest item, waits while queue is empty, returns NULL when queue is empty and closed */
+extern void *queue_pop(setk_queue_t *queue);
+
+/* close queue, pushes fail and pops return remaining items, then NULL */
+extern void queue_close(setk_queue_t *queue);
+
+/* free queue, items are owned by caller */
+extern void queue_destroy(setk_queue_t *queue);
+
+#endif
@@ -0,0 +1,317 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "segment.h"
+#include "i18n.h"
+
+struct segment_job_t;
+
+/* one segment, hops are numbered from start of file, hop h starts at frame h * nslide,
+ * output of hop is written to its first nslide frames */
+typedef struct segment_t {
+    struct segment_job_t *job;
+    setk_processor_t *processor;
+    setk_profile_t *profile;                /* timing of reads, writes and hops, NULL when profiling is off */
+    sf_count_t first_hop;                   /* first hop of pre-roll */
+    sf_count_t start_hop;                   /* first hop whose output is written */
+    sf_count_t end_hop;                     /* first hop of next segment */
+    pthread_t thread;
+} segment_t;
+
+/* segments of one file */
+typedef struct segment_job_t {
+    const setk_mapped_t *input;
+    const setk_downmix_t *downmix;
+    setk_mapped_t *output;                  /* segments write disjoint parts of output */
+    const setk_track_t *track;              /* noise of every hop in two-pass mode, otherwise NULL */
+    int channels;                           /* channels of processing, 1 with downmix */
+    sf_count_t window_size;
+    sf_count_t nslide;
+    sf_count_t frames_done;                 /* frames written by all segments, updated atomically */
+    int running;                            /* segments which were not finished yet */
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+} segment_job_t;
+
+/* read frames of input from frame pos, frames after end of input are zero */
+static void segment_read(const segment_job_t *job, real_t *multi_data, sf_count_t pos, real_t *data,
+                         sf_count_t frames);
+
+/* segment thread */
+static void *segment_worker(void *arg);
+
+/* enhance mapped input into mapped output in segments in parallel */
+sf_count_t process_segments(const setk_options_t *args, int nsegments, setk_processor_t *processor,
+                            const setk_mapped_t *input, const setk_downmix_t *downmix, setk_mapped_t *output,
+                            const setk_track_t *track, setk_progress_t *progress, setk_profile_t *profile) {
+    segment_job_t job;
+    segment_t *segments;
+    sf_count_t hops, preroll;
+    struct timespec deadline;
+    int count;
+
+    memset((void *) &job, 0, sizeof(job));
+    job.input = input;
+    job.downmix = downmix;
+    job.output = output;
+    job.track = track;
+    job.channels = processor->channels;
+    job.window_size = (sf_count_t) processor->window_size;
+    job.nslide = processor->nslide;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.done, NULL);
+
+    /* the last hop starts before end of input, as in framer, segment is at least one hop long */
+    hops = (input->frames + job.nslide - 1) / job.nslide;
+    count = (int) MIN(nsegments, hops);
+
+    /* overlap-add tail at the seam is computed by the previous hop, so pre-roll has at least one hop,
+     * noise of track needs no warm-up, so only decision-directed state is warmed up */
+    preroll = (sf_count_t) ceil((double) args->segment_preroll * processor->samplerate / 1000.0 / job.nslide);
+    if (track != NULL && !snd_enhance_has_state(processor->sound_enhancement))
+        preroll = 1;
+    preroll = MAX(preroll, 1);
+
+    if (args->verbosity)
+        printf(_("Processing %d segments with pre-roll of %ld hops.\n"), count, (long) preroll);
+
+    segments = (segment_t *) calloc((size_t) count, sizeof(*segments));
+    if (segments == NULL) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    job.running = count;
+    for (int k = 0; k < count; ++k) {
+        segment_t *seg = &segments[k];
+
+        seg->job = &job;
+        seg->start_hop = hops * k / count;
+        seg->end_hop = hops * (k + 1) / count;
+        seg->first_hop = MAX(seg->start_hop - preroll, 0);
+        seg->processor = (k == 0) ? processor : processor_clone(processor);
+        seg->profile = (profile != NULL) ? profile_create() : NULL;
+        if (seg->processor == NULL || (profile != NULL && seg->profile == NULL)) {
+            printf(_("\nError: Unable to create processor of segment: %s\n"), strerror(errno));
+            exit(1);
+        }
+        processor_set_first_hop(seg->processor, seg->first_hop);
+
+        if (pthread_create(&seg->thread, NULL, segment_worker, seg) != 0) {
+            printf(_("\nError: Unable to create segment thread: %s\n"), strerror(errno));
+            exit(1);
+        }
+    }
+
+    /* progress is polled, so that segments never wait for main thread */
+    pthread_mutex_lock(&job.lock);
+    while (job.running > 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += SEGMENT_POLL_INTERVAL * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&job.done, &job.lock, &deadline);
+        progress_update(progress, __atomic_load_n(&job.frames_done, __ATOMIC_RELAXED));
+    }
+    pthread_mutex_unlock(&job.lock);
+
+    for (int k = 0; k < count; ++k) {
+        segment_t *seg = &segments[k];
+
+        pthread_join(seg->thread, NULL);
+
+        if (profile != NULL) {
+            profile_merge(profile, seg->profile);
+            if (k > 0)
+                processor_collect_profile(seg->processor, profile);
+        }
+        profile_destroy(seg->profile);
+
+        if (k > 0) {
+            processor_merge_snr_seg(processor, seg->processor);
+            processor_destroy(seg->processor);
+        }
+    }
+
+    /* output is written up to its end, so it is not truncated on close */
+    output->pos = job.frames_done;
+
+    free(segments);
+    pthread_cond_destroy(&job.done);
+    pthread_mutex_destroy(&job.lock);
+
+    return job.frames_done;
+}
+
+/* estimate noise of every hop of input into track, then enhance hops in segments in parallel */
+sf_count_t process_two_pass(const setk_options_t *args, setk_processor_t *processor, const setk_mapped_t *input,
+                            const setk_downmix_t *downmix, setk_mapped_t *output, setk_progress_t *progress,
+                            setk_profile_t *profile) {
+    segment_job_t job;
+    setk_track_t *track;
+    sf_count_t hops, written;
+    real_t *frame, *multi_data = NULL;
+    uint64_t hop_start, t;
+    int nsegments = args->segments;
+
+    memset((void *) &job, 0, sizeof(job));
+    job.input = input;
+    job.downmix = downmix;
+    job.channels = processor->channels;
+    job.window_size = (sf_count_t) processor->window_size;
+    job.nslide = processor->nslide;
+
+    hops = (input->frames + job.nslide - 1) / job.nslide;
+    if ((track = track_create(hops, processor->channels, processor->fft_size / 2 + 1)) == NULL) {
+        printf(_("Error: Unable to create noise track: %s\n"), strerror(errno));
+        return -1;
+    }
+
+    /* without --segments, second pass runs on all processors */
+    if (nsegments == 1)
+        nsegments = (int) MIN(MAX(sysconf(_SC_NPROCESSORS_ONLN), 1), SEGMENTS_MAX);
+
+    if (args->verbosity)
+        puts(_("Pass 1: noise estimation."));
+
+    frame = init_buffer_real((size_t) job.window_size * job.channels);
+    if (downmix != NULL)
+        multi_data = init_buffer_real((size_t) job.window_size * input->channels);
+    if (frame == NULL || (downmix != NULL && multi_data == NULL)) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    /* frame slides over input as in framer, it is only analysed, so nothing is written */
+    segment_read(&job, multi_data, 0, frame, job.window_size);
+    for (sf_count_t hop = 0; hop < hops; ++hop) {
+        progress_update(progress, hop * job.nslide);
+        hop_start = PROFILE_BEGIN(profile);
+
+        processor_estimate(processor, frame, track, hop);
+        t = PROFILE_BEGIN(profile);
+
+        memmove((void *) frame, (void *) (frame + job.nslide * job.channels),
+                sizeof(*frame) * (job.window_size - job.nslide) * job.channels);
+        segment_read(&job, multi_data, hop * job.nslide + job.window_size,
+                     frame + (job.window_size - job.nslide) * job.channels, job.nslide);
+        PROFILE_END(profile, PROFILE_READ, t);
+        PROFILE_END(profile, PROFILE_HOP, hop_start);
+    }
+    progress_finish(progress, input->frames);
+
+    free(frame);
+    free(multi_data);
+
+    /* estimators are done, enhancement starts in initial state */
+    processor_reset(processor);
+    progress_restart(progress);
+
+    if (args->verbosity)
+        puts(_("Pass 2: enhancement."));
+
+    written = process_segments(args, nsegments, processor, input, downmix, output, track, progress, profile);
+
+    track_destroy(track);
+
+    return written;
+}
+
+/* read frames of input from frame pos, frames after end of input are zero as in framer */
+static void segment_read(const segment_job_t *job, real_t *multi_data, sf_count_t pos, real_t *data,
+                         sf_count_t frames) {
+    sf_count_t count;
+
+    if (job->downmix != NULL) {
+        count = mapped_read_at(job->input, pos, multi_data, frames);
+        downmix_mix(job->downmix, multi_data, data, (size_t) count);
+    }
+    else
+        count = mapped_read_at(job->input, pos, data, frames);
+
+    memset((void *) (data + count * job->channels), 0, sizeof(*data) * (frames - count) * job->channels);
+}
+
+/* segment thread, frame slides over input as in framer, its first nslide frames are replaced with output,
+ * output of pre-roll hops is dropped, so the seam is overlap-add of two hops of the same segment */
+static void *segment_worker(void *arg) {
+    segment_t *seg = (segment_t *) arg;
+    segment_job_t *job = seg->job;
+    sf_count_t window_size = job->window_size, nslide = job->nslide, written;
+    real_t *frame = init_buffer_real((size_t) window_size * job->channels);
+    real_t *multi_data = NULL;
+    uint64_t hop_start, t;
+
+    if (job->downmix != NULL)
+        multi_data = init_buffer_real((size_t) window_size * job->input->channels);
+    if (frame == NULL || (job->downmix != NULL && multi_data == NULL)) {
+        printf(_("\nError: malloc() failed: %s\n"), strerror(errno));
+        exit(1);
+    }
+
+    t = PROFILE_BEGIN(seg->profile);
+    segment_read(job, multi_data, seg->first_hop * nslide, frame, window_size);
+    PROFILE_END(seg->profile, PROFILE_READ, t);
+
+    for (sf_count_t hop = seg->first_hop; hop < seg->end_hop; ++hop) {
+        hop_start = t = PROFILE_BEGIN(seg->profile);
+
+        /* run statistics cover the same frames as in one pass */
+        if (hop == seg->start_hop)
+            processor_clear_snr_seg(seg->processor);
+
+        if (job->track != NULL)
+            processor_use_track(seg->processor, job->track, hop);
+
+        processor_run(seg->processor, frame);
+        t = PROFILE_BEGIN(seg->profile);
+
+        if (hop >= seg->start_hop) {
+            written = mapped_write_at(job->output, hop * nslide, frame, nslide);
+            __atomic_add_fetch(&job->frames_done, written, __ATOMIC_RELAXED);
+            PROFILE_END(seg->profile, PROFILE_WRITE, t);
+        }
+
+        t = PROFILE_BEGIN(seg->profile);
+        memmove((void *) frame, (void *) (frame + nslide * job->channels),
+                sizeof(*frame) * (window_size - nslide) * job->channels);
+        segment_read(job, multi_data, hop * nslide + window_size, frame + (window_size - nslide) * job->channels,
+                     nslide);
+        PROFILE_END(seg->profile, PROFILE_READ, t);
+        PROFILE_END(seg->profile, PROFILE_HOP, hop_start);
+    }
+
+    free(frame);
+    free(multi_data);
+
+    pthread_mutex_lock(&job->lock);
+    job->running--;
+    pthread_cond_signal(&job->done);
+    pthread_mutex_unlock(&job->lock);
+
+    return NULL;
+}
@@ -0,0 +1,52 @@
+/********************************************************************
+ function: Segmented Processing
+ contains: long mapped file is split into segments at hop boundaries,
+           which are processed in parallel, every segment starts with
+           pre-roll, which lets noise estimation and decision-directed
+           state converge before its output is written, in two-pass
+           mode noise of all hops is estimated first
+ ********************************************************************/
+
+#ifndef HAVE_SEGMENT_H
+#define HAVE_SEGMENT_H
+
+#include "common.h"
+#include "toolkit.h"
+#include "processor.h"
+#include "downmix.h"
+#include "mapped.h"
+#include "profile.h"
+#include "stats.h"
+#include "track.h"
+#include "snd_enhance.h"
+
+/* maximum number of segments of one file */
+#define SEGMENTS_MAX                        64
+
+/* default pre-roll of segment in milliseconds, minimum statistics estimators track noise over ~1.5 s */
+#define SEGMENT_PREROLL_DEFAULT             2000
+
+/* maximum pre-roll of segment in milliseconds */
+#define SEGMENT_PREROLL_MAX                 60000
+
+/* interval in milliseconds in which progress of segments is polled */
+#define SEGMENT_POLL_INTERVAL               100
+
+/* enhance mapped input into mapped output of the same length in nsegments segments in parallel,
+ * processor processes the first segment, the others are processed by its clones, whose segmental SNR
+ * and timing are added to processor and profile, input is mixed to mono by downmix when it is not NULL,
+ * noise is taken from track when it is not NULL, returns number of written frames */
+extern sf_count_t process_segments(const setk_options_t *args, int nsegments, setk_processor_t *processor,
+                                   const setk_mapped_t *input, const setk_downmix_t *downmix,
+                                   setk_mapped_t *output, const setk_track_t *track, setk_progress_t *progress,
+                                   setk_profile_t *profile);
+
+/* two-pass mode, first pass estimates noise of every hop of mapped input into track on one thread,
+ * second pass enhances it in args->segments segments in parallel, or in one segment per processor,
+ * output of algorithms without state besides noise estimation is the same as in one pass,
+ * returns number of written frames, or -1 when track cannot be created */
+extern sf_count_t process_two_pass(const setk_options_t *args, setk_processor_t *processor,
+                                   const setk_mapped_t *input, const setk_downmix_t *downmix,
+                                   setk_mapped_t *output, setk_progress_t *progress, setk_profile_t *profile);
+
+#endif
@@ -0,0 +1,109 @@
+/********************************************************************
+ function: libsetk
+ contains: public interface of the sound enhancement library, stream
+           of interleaved frames is pushed in buffers of any size and
+           enhanced frames are pulled from it
+ ********************************************************************/
+
+#ifndef HAVE_SETK_H
+#define HAVE_SETK_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* sample type of library, libsetk_float is built with SETK_SINGLE_PRECISION defined,
+ * its clients must define it too */
+#ifdef SETK_SINGLE_PRECISION
+typedef float setk_sample_t;
+#else
+typedef double setk_sample_t;
+#endif
+
+/* stream of one input, e.g. one call of media server, streams are independent and each of them
+ * may be used by another thread */
+typedef struct setk_stream_t setk_stream_t;
+
+/* status of library functions, library never exits on them */
+typedef enum setk_status_t {
+    SETK_OK = 0,
+    SETK_ERROR_ARGUMENT,                    /* NULL stream or buffer, option out of range */
+    SETK_ERROR_FRAME,                       /* window of samplerate is empty or longer than FFT size */
+    SETK_ERROR_DOWNMIX,                     /* downmix weights do not match channels */
+    SETK_ERROR_NOISE_PROFILE,               /* noise profile cannot be read or does not match stream */
+    SETK_ERROR_MEMORY,                      /* buffer of stream cannot be allocated */
+    SETK_ERROR_WRITE,                       /* noise profile cannot be written */
+    SETK_ERROR_THREAD                       /* channel thread of stream cannot be created */
+} setk_status_t;
+
+/* options of stream, names of algorithms are those of toolkit options, NULL and unknown names
+ * select default ones, as in toolkit */
+typedef struct setk_stream_options_t {
+    const char *snd_enhance_type;           /* e.g. "mmse", default specsub */
+    const char *noise_est_type;             /* e.g. "mcra", default vad */
+    const char *window_type;                /* e.g. "hann", default hamming */
+    int frame_duration;                     /* milliseconds, range 10 - 30, default 20 */
+    size_t fft_size;                        /* 0 is optimal size of frame */
+    int overlap;                            /* percent, range 0 - 99, default 50 */
+    int channel_threads;                    /* threads processing channels, default 1 */
+    bool downmix;                           /* channels are mixed to mono before processing */
+    const char *downmix_weights;            /* weight of every channel, e.g. "0.7,0.3", implies downmix */
+    const char *noise_profile;              /* file saved by setk_stream_save_noise_profile(), or NULL */
+} setk_stream_options_t;
+
+/* set default options */
+extern void setk_stream_options_init(setk_stream_options_t *opts);
+
+/* create stream of samplerate and channels, opts NULL are default options, *stream is NULL on error */
+extern setk_status_t setk_stream_create(setk_stream_t **stream, int samplerate, int channels,
+                                        const setk_stream_options_t *opts);
+
+/* push frames of interleaved data, every full frame is enhanced before push returns,
+ * push after setk_stream_flush() starts a new stream, e.g. next call on the same line,
+ * stream is reset after SETK_ERROR_MEMORY, as part of data may be lost */
+extern setk_status_t setk_stream_push(setk_stream_t *stream, const setk_sample_t *data, size_t frames);
+
+/* pull at most frames of enhanced interleaved output into data, returns number of frames,
+ * output is delayed by overlap of frame until it is flushed */
+extern size_t setk_stream_pull(setk_stream_t *stream, setk_sample_t *data, size_t frames);
+
+/* frames of output which are ready to be pulled */
+extern size_t setk_stream_available(const setk_stream_t *stream);
+
+/* end of input, zero padded tail is enhanced, so that output has as many frames as input,
+ * stream is reset after SETK_ERROR_MEMORY */
+extern setk_status_t setk_stream_flush(setk_stream_t *stream);
+
+/* discard input and output of stream and return it to its initial state */
+extern void setk_stream_reset(setk_stream_t *stream);
+
+/* channels of output, 1 when input is mixed to mono */
+extern int setk_stream_channels(const setk_stream_t *stream);
+
+/* frames of input and output of one frame and of one hop */
+extern size_t setk_stream_window_size(const setk_stream_t *stream);
+extern size_t setk_stream_hop_size(const setk_stream_t *stream);
+
+/* mean segmental SNR in dB of output channel over frames of current stream */
+extern double setk_stream_snr_seg(const setk_stream_t *stream, int channel);
+
+/* save state of noise estimation after the last frame into file, which is used by noise_profile option */
+extern setk_status_t setk_stream_save_noise_profile(const setk_stream_t *stream, const char *filename);
+
+/* free stream */
+extern void setk_stream_destroy(setk_stream_t *stream);
+
+/* free FFT plans and window tables shared by streams, once all streams were destroyed */
+extern void setk_cleanup(void);
+
+/* message of status */
+extern const char *setk_strerror(setk_status_t status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
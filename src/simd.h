@@ -0,0 +1,121 @@
+/********************************************************************
+ function: SIMD Abstraction
+ contains: vector of real_t samples for AVX2 or SSE2, whichever is
+           enabled by compiler flags, kernels fall back to scalar code
+           when SETK_SIMD_WIDTH is not defined
+ ********************************************************************/
+
+#ifndef HAVE_SIMD_H
+#define HAVE_SIMD_H
+
+#include "common.h"
+
+#if defined(__AVX2__) && defined(SETK_SINGLE_PRECISION)
+
+#include <immintrin.h>
+
+#define SETK_SIMD_WIDTH                     8
+
+typedef __m256 simd_real_t;
+
+#define simd_load(ptr)                      _mm256_loadu_ps(ptr)
+#define simd_store(ptr, v)                  _mm256_storeu_ps((ptr), (v))
+#define simd_set1(x)                        _mm256_set1_ps(x)
+#define simd_zero()                         _mm256_setzero_ps()
+#define simd_add(a, b)                      _mm256_add_ps((a), (b))
+#define simd_mul(a, b)                      _mm256_mul_ps((a), (b))
+#define simd_sqrt(a)                        _mm256_sqrt_ps(a)
+/* order of elements is reversed, used for imaginary half of halfcomplex array */
+#define simd_reverse(a)                     _mm256_permutevar8x32_ps((a), _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7))
+/* sums of adjacent pairs of a followed by those of b, used for mixing of interleaved channels */
+#define simd_pairwise_add(a, b) \
+    _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_hadd_ps((a), (b))), 0xD8))
+
+/* sum of all elements */
+static inline double simd_hsum(simd_real_t v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+#elif defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define SETK_SIMD_WIDTH                     4
+
+typedef __m256d simd_real_t;
+
+#define simd_load(ptr)                      _mm256_loadu_pd(ptr)
+#define simd_store(ptr, v)                  _mm256_storeu_pd((ptr), (v))
+#define simd_set1(x)                        _mm256_set1_pd(x)
+#define simd_zero()                         _mm256_setzero_pd()
+#define simd_add(a, b)                      _mm256_add_pd((a), (b))
+#define simd_mul(a, b)                      _mm256_mul_pd((a), (b))
+#define simd_sqrt(a)                        _mm256_sqrt_pd(a)
+/* order of elements is reversed, used for imaginary half of halfcomplex array */
+#define simd_reverse(a)                     _mm256_permute4x64_pd((a), 0x1B)
+/* sums of adjacent pairs of a followed by those of b, used for mixing of interleaved channels */
+#define simd_pairwise_add(a, b)             _mm256_permute4x64_pd(_mm256_hadd_pd((a), (b)), 0xD8)
+
+/* sum of all elements */
+static inline double simd_hsum(simd_real_t v) {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+#elif defined(__SSE2__) && defined(SETK_SINGLE_PRECISION)
+
+#include <emmintrin.h>
+
+#define SETK_SIMD_WIDTH                     4
+
+typedef __m128 simd_real_t;
+
+#define simd_load(ptr)                      _mm_loadu_ps(ptr)
+#define simd_store(ptr, v)                  _mm_storeu_ps((ptr), (v))
+#define simd_set1(x)                        _mm_set1_ps(x)
+#define simd_zero()                         _mm_setzero_ps()
+#define simd_add(a, b)                      _mm_add_ps((a), (b))
+#define simd_mul(a, b)                      _mm_mul_ps((a), (b))
+#define simd_sqrt(a)                        _mm_sqrt_ps(a)
+/* order of elements is reversed, used for imaginary half of halfcomplex array */
+#define simd_reverse(a)                     _mm_shuffle_ps((a), (a), 0x1B)
+/* sums of adjacent pairs of a followed by those of b, used for mixing of interleaved channels */
+#define simd_pairwise_add(a, b) \
+    _mm_add_ps(_mm_shuffle_ps((a), (b), _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps((a), (b), _MM_SHUFFLE(3, 1, 3, 1)))
+
+/* sum of all elements */
+static inline double simd_hsum(simd_real_t v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define SETK_SIMD_WIDTH                     2
+
+typedef __m128d simd_real_t;
+
+#define simd_load(ptr)                      _mm_loadu_pd(ptr)
+#define simd_store(ptr, v)                  _mm_storeu_pd((ptr), (v))
+#define simd_set1(x)                        _mm_set1_pd(x)
+#define simd_zero()                         _mm_setzero_pd()
+#define simd_add(a, b)                      _mm_add_pd((a), (b))
+#define simd_mul(a, b)                      _mm_mul_pd((a), (b))
+#define simd_sqrt(a)                        _mm_sqrt_pd(a)
+/* order of elements is reversed, used for imaginary half of halfcomplex array */
+#define simd_reverse(a)                     _mm_shuffle_pd((a), (a), 1)
+/* sums of adjacent pairs of a followed by those of b, used for mixing of interleaved channels */
+#define simd_pairwise_add(a, b)             _mm_add_pd(_mm_unpacklo_pd((a), (b)), _mm_unpackhi_pd((a), (b)))
+
+/* sum of all elements */
+static inline double simd_hsum(simd_real_t v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#endif
+
+#endif
@@ -22,17 +22,72 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 #include "snd_enhance.h"
+#include "noise_est_bin.h"
 #include "tbessi.h"
 #include "lpc.h"
 #include "i18n.h"
 
+/* table of MMSE gain without speech presence uncertainty over a priori SNR ksi
+ * and a posteriori SNR gamma in dB, ksi is limited to -25 dB and gamma to 40,
+ * i.e. 16 dB, by the algorithm, interpolation error is below 0.2 % */
+#define MMSE_TABLE_STEP_DB                  0.5
+#define MMSE_KSI_MIN_DB                     -25.0
+#define MMSE_KSI_POINTS                     131 /* up to 40 dB */
+#define MMSE_GAMMA_MIN_DB                   -30.0
+#define MMSE_GAMMA_POINTS                   95 /* up to 17 dB */
+
+static real_t mmse_table[MMSE_KSI_POINTS][MMSE_GAMMA_POINTS];
+static pthread_once_t mmse_table_once = PTHREAD_ONCE_INIT;
+
 /* Required in spectral substraction algorithm */
 static double berouti(double SNR); /* if alpha == 2 */
 
 /* calculate segmentary SNR */
 static double calc_snr_seg(double norm_signal, double norm_noise);
 
+/* MMSE gain with speech presence uncertainty, table is used inside its range */
+static inline double mmse_gain(double ksi, double gammak);
+
+/* MMSE gain without speech presence uncertainty, i.e. tabulated function */
+static double mmse_hw_exact(double ksi, double gammak);
+
+/* MMSE gain with speech presence uncertainty evaluated without table */
+static double mmse_gain_exact(double ksi, double gammak);
+
+/* fill MMSE gain table, run once */
+static void mmse_table_init(void);
+
+/* gain of spectral substraction for one bin */
+static inline real_t specsub_gain(real_t y_ps, real_t noise_ps, double beta);
+
+/* gain of one bin from its power and noise power, it may update state of algorithm in context */
+typedef real_t (*gain_bin_func_t)(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps);
+
+/* gain of MMSE, wiener-as and residual output for one bin */
+static inline real_t mmse_gain_bin(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps);
+static inline real_t wiener_as_gain_bin(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps);
+static inline real_t residual_gain_bin(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps);
+
+/* power spectrum and noise estimation of frame, gain of gain_bin is applied to spectrum, unless it is NULL */
+static inline double estimate_spectra(setk_context_t *ctx, real_t *fft_data, size_t fft_size,
+                                      noise_est_func_t noise_estimation, int samplerate,
+                                      real_t *y_ps, real_t *noise_ps, double *norm_ps, gain_bin_func_t gain_bin);
+
+/* power spectrum of frame, noise was estimated by first pass of two-pass mode */
+static double track_spectra(const setk_context_t *ctx, const real_t *fft_data, size_t fft_size,
+                            real_t *y_ps, real_t *noise_ps, double *norm_ps);
+
+/* power spectrum, noise estimation and gain in one sweep over bins, noise_bin and gain_bin are inlined */
+static inline double power_noise_sweep(setk_context_t *ctx, real_t *fft_data, size_t fft_size,
+                                       double SNRseg, real_t *y_ps, real_t *noise_ps, double *norm_ps,
+                                       noise_est_bin_func_t noise_bin, gain_bin_func_t gain_bin);
+
+/* apply gain of gain_bin to spectrum, when noise was not estimated by sweep */
+static inline void gain_sweep(setk_context_t *ctx, real_t *fft_data, size_t fft_size, const real_t *y_ps,
+                              const real_t *noise_ps, gain_bin_func_t gain_bin);
+
 snd_enh_func_t parse_snd_enhance_type(const char *name, bool verbose) {
     if (name == NULL) {
         if (verbose)
@@ -55,6 +110,35 @@ snd_enh_func_t parse_snd_enhance_type(const char *name, bool verbose) {
     return snd_enhance_specsub;
 }
 
+/* decision-directed algorithms estimate a priori SNR from gain of previous frame */
+bool snd_enhance_has_state(snd_enh_func_t sound_enhancement) {
+    return sound_enhancement == snd_enhance_mmse || sound_enhancement == snd_enhance_wiener_as;
+}
+
+/* noise estimation of frame without enhancement, first pass of two-pass mode */
+double snd_enhance_estimate(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                            noise_est_func_t noise_estimation, int samplerate, real_t *noise_ps) {
+    setk_arena_t *scratch = &ctx->scratch;
+    uint64_t t; /* start of profiled stage */
+    real_t *y_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum */
+    double norm_ps, norm_ns_ps;
+
+    /* FFT */
+    t = PROFILE_BEGIN(ctx->profile);
+    FFTW(execute_r2r)(fft_forw, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_FORW, t);
+
+    /* power spectrum and noise estimation, segmental SNR is the same as in enhancement of frame */
+    norm_ns_ps = estimate_spectra(ctx, fft_data, fft_size, noise_estimation, samplerate, y_ps, noise_ps, &norm_ps,
+                                  NULL);
+    ctx->enh.SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    PROFILE_END(ctx->profile, PROFILE_NOISE_EST, t);
+
+    arena_reset(scratch);
+
+    return norm_ns_ps;
+}
+
 char *get_snd_enhance_name(const char *name) {
     if (name == NULL) {
         return (_("Spectral substraction algorithm (default)"));
@@ -73,260 +157,179 @@ char *get_snd_enhance_name(const char *name) {
     return (_("Spectral substraction algorithm (default)"));
 }
 
-void snd_enhance_specsub(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                         noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
-    /* initialize variables */
-    double *y_ps = init_buffer_dbl(fft_size / 2 + 1); /* power spectrum */
-    double *y_phase = init_buffer_dbl(fft_size / 2 + 1); /* phase */
-    double *noise_ps = init_buffer_dbl(fft_size / 2 + 1); /* noise power spectrum */
+void snd_enhance_specsub(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                         fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
+    /* initialize variables, per-frame buffers are taken from scratch arena */
+    setk_arena_t *scratch = &ctx->scratch;
+    uint64_t t; /* start of profiled stage */
+    real_t *y_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum */
+    real_t *noise_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* noise power spectrum */
+    size_t last = (fft_size - 1) / 2; /* last bin with imaginary part */
     double norm_ps, norm_ns_ps, beta;
-    static double SNRseg = 0.0;
-    const double floor = 0.002;
+    real_t gain;
 
     /* FFT */
-    fftw_execute(fft_forw);
-
-    calc_magnitude(fft_data, fft_size, y_ps);
-
-    calc_phase(fft_data, fft_size, y_phase);
+    t = PROFILE_BEGIN(ctx->profile);
+    FFTW(execute_r2r)(fft_forw, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_FORW, t);
 
-    norm_ps = calc_power_spectrum(y_ps, fft_size, y_ps);
+    /* power spectrum and noise estimation, gain depends on segmental SNR of whole frame, so it is applied
+     * in second sweep */
+    norm_ns_ps = estimate_spectra(ctx, fft_data, fft_size, noise_estimation, samplerate, y_ps, noise_ps, &norm_ps,
+                                  NULL);
+    PROFILE_END(ctx->profile, PROFILE_NOISE_EST, t);
 
-    /* noise estimation */
-    norm_ns_ps = noise_estimation(y_ps, fft_size, noise_ps, SNRseg, samplerate);
+    ctx->enh.SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
 
-    SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    beta = berouti(ctx->enh.SNRseg);
 
-    beta = berouti(SNRseg);
+    /* spectral substraction, gain is applied to complex spectrum in the same sweep, so phase is kept */
+    fft_data[0] *= specsub_gain(y_ps[0], noise_ps[0], beta);
 
-    /* spectral substraction */
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        y_ps[i] = y_ps[i] - beta * noise_ps[i];
-        if ((y_ps[i] - floor * noise_ps[i]) < 0) {
-            /* floor negative components */
-            y_ps[i] = floor * noise_ps[i];
-        }
-        /* create enhanced magnitude spectrum */
-        y_ps[i] = sqrt(y_ps[i]);
+    for (size_t i = 1; i <= last; ++i) {
+        gain = specsub_gain(y_ps[i], noise_ps[i], beta);
+        fft_data[i] *= gain;
+        fft_data[fft_size - i] *= gain;
     }
 
-    /* recreate frequency spectrum from magnitude and phase */
-    calc_fft_complex_data(y_ps, y_phase, fft_size, fft_data);
+    /* Nyquist bin, fft_size is even */
+    if (fft_size % 2 == 0)
+        fft_data[fft_size / 2] *= specsub_gain(y_ps[fft_size / 2], noise_ps[fft_size / 2], beta);
+
+    PROFILE_END(ctx->profile, PROFILE_GAIN, t);
 
     /* IFFT */
-    fftw_execute(fft_back);
+    FFTW(execute_r2r)(fft_back, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_BACK, t);
 
-    free(y_ps);
-    free(y_phase);
-    free(noise_ps);
+    arena_reset(scratch);
 }
 
-void snd_enhance_mmse(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                      noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
-    /* initialize variables */
-    double *y_ps = init_buffer_dbl(fft_size / 2 + 1); /* power spectrum */
-    double *y_phase = init_buffer_dbl(fft_size / 2 + 1); /* phase */
-    double *noise_ps = init_buffer_dbl(fft_size / 2 + 1); /* noise power spectrum */
+void snd_enhance_mmse(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                      fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
+    /* initialize variables, per-frame buffers are taken from scratch arena */
+    setk_arena_t *scratch = &ctx->scratch;
+    uint64_t t; /* start of profiled stage */
+    real_t *y_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum */
+    real_t *noise_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* noise power spectrum */
     double norm_ps, norm_ns_ps;
-    static double Xk_prev[FFT_MAX / 2 + 1];
-    static double SNRseg = 0.0;
-    static int calls = 0;
 
-    /* MMSE parameters */
-    const double aa = 0.98;
-    const double c = sqrt(M_PI) / 2;
-    const double qk = 0.3;
-    const double qkr = (1 - qk) / qk;
-    const double ksi_min = pow(10, -2.5);
-    double gammak, ksi, max, vk, j0, j1, A, B, C, hw, evk, Lambda, pSAP;
+    /* gain table is shared by all streams */
+    pthread_once(&mmse_table_once, mmse_table_init);
 
     /* FFT */
-    fftw_execute(fft_forw);
-
-    calc_magnitude(fft_data, fft_size, y_ps);
-
-    calc_phase(fft_data, fft_size, y_phase);
-
-    norm_ps = calc_power_spectrum(y_ps, fft_size, y_ps);
-
-    /* noise estimation */
-    norm_ns_ps = noise_estimation(y_ps, fft_size, noise_ps, SNRseg, samplerate);
+    t = PROFILE_BEGIN(ctx->profile);
+    FFTW(execute_r2r)(fft_forw, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_FORW, t);
 
-    SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    /* power spectrum, noise estimation and gain of every bin in one sweep, gain depends only on the bin
+     * and on the previous frame, so time of gain is part of noise estimation stage */
+    norm_ns_ps = estimate_spectra(ctx, fft_data, fft_size, noise_estimation, samplerate, y_ps, noise_ps, &norm_ps,
+                                  mmse_gain_bin);
+    PROFILE_END(ctx->profile, PROFILE_NOISE_EST, t);
 
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        gammak = check_nan(y_ps[i] / noise_ps[i]);
-
-        if (gammak > 40)
-            gammak = 40;
-
-        max = ((gammak - 1) > 0) ? (gammak - 1) : 0;
-
-        if (calls == 0)
-            ksi = aa + (1 - aa) * max;
-        else {
-            ksi = check_nan(aa * Xk_prev[i] / noise_ps[i]) + (1 - aa) * max;
-            /* decision-direct estimate of a priori SNR */
-            if (ksi < ksi_min)
-                ksi = ksi_min; /* limit ksi to -25 dB */
-        }
-
-        vk = ksi * gammak / (1 + ksi);
-        j0 = BESSI(0, vk / 2);
-        j1 = BESSI(1, vk / 2);
-
-        /* --------------- */
-        C = exp(-0.5 * vk);
-        A = ((c * pow(vk, 0.5)) * C) / gammak;
-        B = (1 + vk) * j0 + vk * j1;
-        hw = A * B;
-
-        /* Speech Presence Uncertainity */
-        evk = exp(vk);
-        Lambda = qkr * evk / (1 + ksi);
-        pSAP = Lambda / (1 + Lambda);
-
-        y_ps[i] = sqrt(y_ps[i]) * hw * pSAP; /* enhanced magnitude spectrum */
-
-        Xk_prev[i] = pow(y_ps[i], 2);
-
-    }
-
-    /* recreate frequency spectrum from magnitude and phase */
-    calc_fft_complex_data(y_ps, y_phase, fft_size, fft_data);
+    ctx->enh.SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    PROFILE_END(ctx->profile, PROFILE_GAIN, t);
 
     /* IFFT */
-    fftw_execute(fft_back);
+    FFTW(execute_r2r)(fft_back, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_BACK, t);
 
-    calls++;
+    ctx->enh.calls++;
 
-    free(y_ps);
-    free(y_phase);
-    free(noise_ps);
+    arena_reset(scratch);
 }
 
-void snd_enhance_wiener_as(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                           noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
-    /* initialize variables */
-    double *y_ps = init_buffer_dbl(fft_size / 2 + 1); /* power spectrum */
-    double *noise_ps = init_buffer_dbl(fft_size / 2 + 1); /* noise power spectrum */
-    double *priori = init_buffer_dbl(fft_size / 2 + 1);
-    double *posteri = init_buffer_dbl(fft_size / 2 + 1);
-    double *posteri_prime = init_buffer_dbl(fft_size / 2 + 1);
-    double *G = init_buffer_dbl(fft_size / 2 + 1);
-    static double posteri_prev[
-            FFT_MAX / 2 + 1]; /* needs to be static array, because it must remember its previous state */
-    static double G_prev[FFT_MAX / 2 + 1];
+void snd_enhance_wiener_as(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                           fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
+    /* initialize variables, per-frame buffers are taken from scratch arena */
+    setk_arena_t *scratch = &ctx->scratch;
+    uint64_t t; /* start of profiled stage */
+    real_t *y_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum */
+    real_t *noise_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* noise power spectrum */
     double norm_ps, norm_ns_ps;
-    static double SNRseg = 0.0;
-    static int calls = 0;
-    const double a_dd = 0.98;
 
     /* FFT */
-    fftw_execute(fft_forw);
-
-    calc_magnitude(fft_data, fft_size, y_ps);
-
-    norm_ps = calc_power_spectrum(y_ps, fft_size, y_ps);
-
-    /* noise estimation */
-    norm_ns_ps = noise_estimation(y_ps, fft_size, noise_ps, SNRseg, samplerate);
-
-    SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
-
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        posteri[i] = check_nan(y_ps[i] / noise_ps[i]);
-
-        posteri_prime[i] = posteri[i] - 1;
+    t = PROFILE_BEGIN(ctx->profile);
+    FFTW(execute_r2r)(fft_forw, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_FORW, t);
 
-        if (posteri_prime[i] < 0)
-            posteri_prime[i] = 0;
+    /* power spectrum, noise estimation and gain of every bin in one sweep, gain depends only on the bin
+     * and on the previous frame, so time of gain is part of noise estimation stage */
+    norm_ns_ps = estimate_spectra(ctx, fft_data, fft_size, noise_estimation, samplerate, y_ps, noise_ps, &norm_ps,
+                                  wiener_as_gain_bin);
+    PROFILE_END(ctx->profile, PROFILE_NOISE_EST, t);
 
-        if (calls == 0)
-            priori[i] = a_dd + (1 - a_dd) * posteri_prime[i];
-        else
-            priori[i] = a_dd * pow(G_prev[i], 2) * posteri_prev[i] + (1 - a_dd) * posteri_prime[i];
-
-        /* Gain function */
-        G[i] = sqrt(priori[i] / (1 + priori[i]));
-    }
-
-    /* Multiply FFT spectrum with gain function */
-    multiply_fft_spec_with_gain(G, fft_size, fft_data);
+    ctx->enh.SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    PROFILE_END(ctx->profile, PROFILE_GAIN, t);
 
     /* IFFT */
-    fftw_execute(fft_back);
+    FFTW(execute_r2r)(fft_back, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_BACK, t);
 
-    memcpy((void *) G_prev, (void *) G, sizeof(*G) * (fft_size / 2 + 1));
-    memcpy((void *) posteri_prev, (void *) posteri, sizeof(*posteri) * (fft_size / 2 + 1));
+    ctx->enh.calls++;
 
-    calls++;
-
-    free(y_ps);
-    free(noise_ps);
-    free(posteri);
-    free(posteri_prime);
-    free(priori);
-    free(G);
+    arena_reset(scratch);
 }
 
-void snd_enhance_wiener_iter(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                             noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
-    /* initialize variables */
-    const int pred_order = 12; /* LPC order */
+void snd_enhance_wiener_iter(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                             fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
+    /* initialize variables, per-frame buffers are taken from scratch arena */
+    const int pred_order = LPC_ORDER;
     const int iter_num = 3;
     const double min_energy = 1e-16;
-    double *y_ps = init_buffer_dbl(fft_size / 2 + 1); /* power spectrum */
-    double *noise_ps = init_buffer_dbl(fft_size / 2 + 1); /* noise power spectrum */
-    double *xx = init_buffer_dbl(fft_size / 2 + 1);
-    double xx_tmp[2]; /* tmp variable for xx array, contains real and imag data */
-    double *h_spec = init_buffer_dbl(fft_size / 2 + 1);
-    double *lpc_coeffs = init_buffer_dbl(sizeof(*lpc_coeffs) * pred_order); /* LPC coefficients */
+    setk_arena_t *scratch = &ctx->scratch;
+    uint64_t t; /* start of profiled stage */
+    real_t *y_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum */
+    real_t *noise_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* noise power spectrum */
+    real_t *xx = arena_alloc_real(scratch, fft_size / 2 + 1);
+    real_t *lpc_spec = arena_alloc_real(scratch, fft_size); /* zero padded LPC polynomial and its spectrum */
+    real_t *h_spec = arena_alloc_real(scratch, fft_size / 2 + 1);
+    real_t *x_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum of filtered frame */
+    real_t *lpc_coeffs = arena_alloc_real(scratch, (size_t) pred_order); /* LPC coefficients */
     double norm_ps, norm_ns_ps;
-    static double SNRseg = 0.0;
     double mean_tmp = 0;
     double lpc_energy = 0;
     double g = 0; /* gain */
 
-    lpc_from_data(fft_data, lpc_coeffs, (int) datalen, pred_order);
-
     /* FFT */
-    fftw_execute(fft_forw);
+    t = PROFILE_BEGIN(ctx->profile);
+    FFTW(execute_r2r)(fft_forw, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_FORW, t);
 
-    calc_magnitude(fft_data, fft_size, y_ps);
+    /* power spectrum and noise estimation, wiener filter depends on LPC model of whole frame */
+    norm_ns_ps = estimate_spectra(ctx, fft_data, fft_size, noise_estimation, samplerate, y_ps, noise_ps, &norm_ps,
+                                  NULL);
+    PROFILE_END(ctx->profile, PROFILE_NOISE_EST, t);
 
-    norm_ps = calc_power_spectrum(y_ps, fft_size, y_ps);
+    /* LPC of noisy frame, frame is zero padded to fft_size, so circular autocorrelation
+     * of power spectrum equals linear one of time domain data */
+    lpc_from_power_spectrum(y_ps, fft_size, fft_back, lpc_coeffs, pred_order, lpc_spec);
 
-    /* noise estimation */
-    norm_ns_ps = noise_estimation(y_ps, fft_size, noise_ps, SNRseg, samplerate);
+    ctx->enh.SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
 
-    SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    /* energy of noise-free signal does not change between iterations */
+    for (size_t i = 0; i <= fft_size / 2; ++i)
+        mean_tmp += y_ps[i] - noise_ps[i];
 
     /* wiener iterations */
     for (int k = 0; k < iter_num; ++k) {
 
+        /* A(z) of LPC model is evaluated by FFT of zero padded coefficients,
+         * first LPC coefficient, e.g. 1.0, is not in array */
+        lpc_spec[0] = 1.0;
+        memcpy((void *) (lpc_spec + 1), (void *) lpc_coeffs, sizeof(*lpc_spec) * pred_order);
+        memset((void *) (lpc_spec + pred_order + 1), 0, sizeof(*lpc_spec) * (fft_size - pred_order - 1));
+
+        FFTW(execute_r2r)(fft_forw, lpc_spec, lpc_spec);
+
+        calc_magnitude(lpc_spec, fft_size, xx);
+
+        /* all-pole spectrum 1 / |A|^2 */
+        lpc_energy = 0.0;
         for (size_t i = 0; i <= fft_size / 2; ++i) {
-            if (i == 0) {
-                lpc_energy = 0.0;
-                mean_tmp = 0.0;
-            }
-
-            for (int j = 0; j <= pred_order; ++j) {
-                if (j == 0) {
-                    /* first LPC coefficient, e.g. 1.0, is not in array */
-                    xx_tmp[0] = 1.0;
-                    xx_tmp[1] = 0.0;
-                }
-                else {
-                    xx_tmp[0] += cos(j * i * 2 * M_PI / fft_size) * lpc_coeffs[j - 1];
-                    xx_tmp[1] += sin(j * i * 2 * M_PI / fft_size) * lpc_coeffs[j - 1];
-                }
-            }
-            /* calc magnitude spectrum value from xx_tmp */
-            xx[i] = sqrt(xx_tmp[0] * xx_tmp[0] + xx_tmp[1] * xx_tmp[1]);
             xx[i] = 1.0 / (xx[i] * xx[i]);
             lpc_energy += xx[i];
-            mean_tmp += y_ps[i] - noise_ps[i];
         }
 
         g = check_nan(mean_tmp / lpc_energy);
@@ -342,30 +345,23 @@ void snd_enhance_wiener_iter(double *fft_data, size_t fft_size, fftw_plan fft_fo
         /* Multiply FFT spectrum with gain function */
         multiply_fft_spec_with_gain(h_spec, fft_size, fft_data);
 
-        /* IFFT */
-        fftw_execute(fft_back);
-
+        /* calculate new LPC coefficients from power spectrum of filtered frame,
+         * spectrum stays in frequency domain until last iteration */
         if (k < iter_num - 1) {
-            for (size_t i = 0; i < fft_size; ++i) {
-                if (i < datalen)
-                    fft_data[i] = fft_data[i] / fft_size;
-                else
-                    fft_data[i] = 0;
-            }
-
-            /* calculate new LPC coefficients */
-            lpc_from_data(fft_data, lpc_coeffs, (int) fft_size, pred_order);
-
-            /* FFT */
-            fftw_execute(fft_forw);
+            calc_magnitude(fft_data, fft_size, x_ps);
+            calc_power_spectrum(x_ps, fft_size, x_ps);
+
+            lpc_from_power_spectrum(x_ps, fft_size, fft_back, lpc_coeffs, pred_order, lpc_spec);
         }
     }
 
-    free(y_ps);
-    free(noise_ps);
-    free(lpc_coeffs);
-    free(xx);
-    free(h_spec);
+    PROFILE_END(ctx->profile, PROFILE_GAIN, t);
+
+    /* IFFT */
+    FFTW(execute_r2r)(fft_back, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_BACK, t);
+
+    arena_reset(scratch);
 }
 
 /* Required in spectral substraction algorithm */
@@ -389,40 +385,304 @@ static double calc_snr_seg(double norm_signal, double norm_noise) {
     return SNRseg;
 }
 
-void snd_enhance_residual(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                          noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
-    /* initialize variables */
-    double *y_ps = init_buffer_dbl(fft_size / 2 + 1); /* power spectrum */
-    double *y_phase = init_buffer_dbl(fft_size / 2 + 1); /* phase */
-    double *noise_ps = init_buffer_dbl(fft_size / 2 + 1); /* noise power spectrum */
-    double norm_ps, norm_ns_ps;
-    static double SNRseg = 0.0;
+/* MMSE gain with speech presence uncertainty, MMSE gain is interpolated from table */
+static inline double mmse_gain(double ksi, double gammak) {
+    const double qk = 0.3;
+    const double qkr = (1 - qk) / qk;
+    double x = (10 * log10(ksi) - MMSE_KSI_MIN_DB) / MMSE_TABLE_STEP_DB;
+    double y = (10 * log10(gammak) - MMSE_GAMMA_MIN_DB) / MMSE_TABLE_STEP_DB;
+    double a, b, hw, pSAP;
+    int k, g;
 
-    /* FFT */
-    fftw_execute(fft_forw);
+    /* outside of table, also catches NaN */
+    if (!(x >= 0 && x < MMSE_KSI_POINTS - 1 && y >= 0 && y < MMSE_GAMMA_POINTS - 1))
+        return mmse_gain_exact(ksi, gammak);
+
+    k = (int) x;
+    g = (int) y;
+    a = x - k;
+    b = y - g;
 
+    /* bilinear interpolation in dB domain */
+    hw = (1 - a) * ((1 - b) * mmse_table[k][g] + b * mmse_table[k][g + 1]) +
+         a * ((1 - b) * mmse_table[k + 1][g] + b * mmse_table[k + 1][g + 1]);
+
+    /* Speech Presence Uncertainity is a steep function of gamma, it is not tabulated */
+    pSAP = 1 / (1 + (1 + ksi) * exp(-ksi * gammak / (1 + ksi)) / qkr);
+
+    return hw * pSAP;
+}
+
+/* MMSE gain, hw is evaluated with exponentially scaled Bessel functions */
+static double mmse_hw_exact(double ksi, double gammak) {
+    const double c = sqrt(M_PI) / 2;
+    double vk = ksi * gammak / (1 + ksi);
+
+    /* exp(-vk / 2) is folded into scaled Bessel functions */
+    return (c * sqrt(vk) / gammak) * ((1 + vk) * BESSIE(0, vk / 2) + vk * BESSIE(1, vk / 2));
+}
+
+/* MMSE gain with speech presence uncertainty evaluated without table */
+static double mmse_gain_exact(double ksi, double gammak) {
+    const double qk = 0.3;
+    const double qkr = (1 - qk) / qk;
+    double vk = ksi * gammak / (1 + ksi);
+    double pSAP;
+
+    /* Speech Presence Uncertainity, Lambda / (1 + Lambda) without exp(vk) */
+    pSAP = 1 / (1 + (1 + ksi) * exp(-vk) / qkr);
+
+    return check_nan(mmse_hw_exact(ksi, gammak) * pSAP);
+}
+
+/* fill MMSE gain table */
+static void mmse_table_init(void) {
+    for (int k = 0; k < MMSE_KSI_POINTS; ++k) {
+        double ksi = pow(10, (MMSE_KSI_MIN_DB + k * MMSE_TABLE_STEP_DB) / 10);
+
+        for (int g = 0; g < MMSE_GAMMA_POINTS; ++g)
+            mmse_table[k][g] = mmse_hw_exact(ksi, pow(10, (MMSE_GAMMA_MIN_DB + g * MMSE_TABLE_STEP_DB) / 10));
+    }
+}
+
+/* gain of spectral substraction for one bin */
+static inline real_t specsub_gain(real_t y_ps, real_t noise_ps, double beta) {
+    const double floor = 0.002;
+    double enh_ps = y_ps - beta * noise_ps;
+
+    if ((enh_ps - floor * noise_ps) < 0) {
+        /* floor negative components */
+        enh_ps = floor * noise_ps;
+    }
+
+    /* gain of enhanced magnitude spectrum */
+    return check_nan(sqrt(enh_ps / y_ps));
+}
+
+/* MMSE gain of one bin, a priori SNR is estimated from enhanced power of previous frame */
+static inline real_t mmse_gain_bin(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps) {
+    /* MMSE parameters */
+    const double aa = 0.98;
+    const double ksi_min = pow(10, -2.5);
+    real_t *Xk_prev = ctx->enh.Xk_prev;
+    double gammak, ksi, max;
+    real_t gain;
+
+    gammak = check_nan(y_ps / noise_ps);
+
+    if (gammak > 40)
+        gammak = 40;
+
+    max = ((gammak - 1) > 0) ? (gammak - 1) : 0;
+
+    if (ctx->enh.calls == 0)
+        ksi = aa + (1 - aa) * max;
+    else {
+        ksi = check_nan(aa * Xk_prev[i] / noise_ps) + (1 - aa) * max;
+        /* decision-direct estimate of a priori SNR */
+        if (ksi < ksi_min)
+            ksi = ksi_min; /* limit ksi to -25 dB */
+    }
+
+    gain = mmse_gain(ksi, gammak); /* enhanced magnitude spectrum is sqrt(y_ps) * gain */
+
+    Xk_prev[i] = y_ps * gain * gain;
+
+    return gain;
+}
+
+/* gain of wiener filter of one bin, a priori SNR is estimated from gain and a posteriori SNR
+ * of previous frame, which are replaced by those of this frame */
+static inline real_t wiener_as_gain_bin(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps) {
+    const double a_dd = 0.98;
+    real_t *posteri_prev = ctx->enh.posteri_prev; /* previous state is kept in context */
+    real_t *G_prev = ctx->enh.G_prev;
+    real_t priori, posteri, posteri_prime, gain;
+
+    posteri = check_nan(y_ps / noise_ps);
+
+    posteri_prime = posteri - 1;
+
+    if (posteri_prime < 0)
+        posteri_prime = 0;
+
+    if (ctx->enh.calls == 0)
+        priori = a_dd + (1 - a_dd) * posteri_prime;
+    else
+        priori = a_dd * pow(G_prev[i], 2) * posteri_prev[i] + (1 - a_dd) * posteri_prime;
+
+    /* Gain function */
+    gain = sqrt(priori / (1 + priori));
+
+    G_prev[i] = gain;
+    posteri_prev[i] = posteri;
+
+    return gain;
+}
+
+/* gain of one bin, which turns magnitude spectrum into noise magnitude spectrum */
+static inline real_t residual_gain_bin(setk_context_t *ctx, size_t i, real_t y_ps, real_t noise_ps) {
+    return check_nan(sqrt(noise_ps / y_ps));
+}
+
+/* power spectrum and noise estimation of frame, gain is applied in the same sweep */
+static inline double estimate_spectra(setk_context_t *ctx, real_t *fft_data, size_t fft_size,
+                                      noise_est_func_t noise_estimation, int samplerate,
+                                      real_t *y_ps, real_t *noise_ps, double *norm_ps, gain_bin_func_t gain_bin) {
+    double SNRseg = ctx->enh.SNRseg;
+    double norm_ns_ps;
+
+    /* noise of whole frame is known before sweep */
+    if (ctx->track_noise_ps != NULL) {
+        norm_ns_ps = track_spectra(ctx, fft_data, fft_size, y_ps, noise_ps, norm_ps);
+        gain_sweep(ctx, fft_data, fft_size, y_ps, noise_ps, gain_bin);
+        return norm_ns_ps;
+    }
+
+    /* each kernel gets its own copy of the sweep */
+    if (noise_estimation == vad_estimation)
+        return power_noise_sweep(ctx, fft_data, fft_size, SNRseg, y_ps, noise_ps, norm_ps, vad_bin, gain_bin);
+    if (noise_estimation == hirsch_estimation)
+        return power_noise_sweep(ctx, fft_data, fft_size, SNRseg, y_ps, noise_ps, norm_ps, hirsch_bin, gain_bin);
+    if (noise_estimation == doblinger_estimation)
+        return power_noise_sweep(ctx, fft_data, fft_size, SNRseg, y_ps, noise_ps, norm_ps, doblinger_bin,
+                                 gain_bin);
+    if (noise_estimation == mcra_estimation)
+        return power_noise_sweep(ctx, fft_data, fft_size, SNRseg, y_ps, noise_ps, norm_ps, mcra_bin, gain_bin);
+    if (noise_estimation == mcra2_estimation)
+        return power_noise_sweep(ctx, fft_data, fft_size, SNRseg, y_ps, noise_ps, norm_ps, mcra2_bin, gain_bin);
+
+    /* estimator without per-bin kernel */
     calc_magnitude(fft_data, fft_size, y_ps);
+    *norm_ps = calc_power_spectrum(y_ps, fft_size, y_ps);
 
-    calc_phase(fft_data, fft_size, y_phase);
+    norm_ns_ps = noise_estimation(&ctx->noise, y_ps, fft_size, noise_ps, SNRseg, samplerate);
+    gain_sweep(ctx, fft_data, fft_size, y_ps, noise_ps, gain_bin);
+
+    return norm_ns_ps;
+}
 
-    norm_ps = calc_power_spectrum(y_ps, fft_size, y_ps);
+/* power spectrum of frame, bins are summed in the same order as by sweep, so that segmental SNR
+ * is the same as in one pass */
+static double track_spectra(const setk_context_t *ctx, const real_t *fft_data, size_t fft_size,
+                            real_t *y_ps, real_t *noise_ps, double *norm_ps) {
+    size_t last = (fft_size - 1) / 2; /* last bin with imaginary part */
+    double norm;
 
-    /* noise estimation */
-    norm_ns_ps = noise_estimation(y_ps, fft_size, noise_ps, SNRseg, samplerate);
+    y_ps[0] = fft_data[0] * fft_data[0];
+    norm = y_ps[0];
 
-    SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    for (size_t i = 1; i <= last; ++i) {
+        y_ps[i] = fft_data[i] * fft_data[i] + fft_data[fft_size - i] * fft_data[fft_size - i];
+        norm += y_ps[i];
+    }
 
-    for (size_t i = 0; i <= fft_size / 2; ++i) {
-        noise_ps[i] = sqrt(noise_ps[i]);
+    /* Nyquist bin, fft_size is even */
+    if (fft_size % 2 == 0) {
+        y_ps[fft_size / 2] = fft_data[fft_size / 2] * fft_data[fft_size / 2];
+        norm += y_ps[fft_size / 2];
     }
 
-    /* recreate frequency spectrum from magnitude and phase */
-    calc_fft_complex_data(noise_ps, y_phase, fft_size, fft_data);
+    memcpy((void *) noise_ps, (void *) ctx->track_noise_ps, sizeof(*noise_ps) * (fft_size / 2 + 1));
+
+    *norm_ps = norm;
+    return ctx->track_norm_ns_ps;
+}
+
+/* power spectrum, noise estimation and gain in one sweep over bins, gain is applied to complex spectrum,
+ * so phase is kept */
+static inline double power_noise_sweep(setk_context_t *ctx, real_t *fft_data, size_t fft_size,
+                                       double SNRseg, real_t *y_ps, real_t *noise_ps, double *norm_ps,
+                                       noise_est_bin_func_t noise_bin, gain_bin_func_t gain_bin) {
+    noise_est_state_t *state = &ctx->noise;
+    size_t last = (fft_size - 1) / 2; /* last bin with imaginary part */
+    double norm_ns_ps = 0.0;
+    double norm = 0.0;
+    real_t gain;
+
+    /* DC bin has no imaginary part */
+    y_ps[0] = fft_data[0] * fft_data[0];
+    norm += y_ps[0];
+    noise_ps[0] = noise_bin(state, 0, y_ps[0], SNRseg, &norm_ns_ps);
+    if (gain_bin != NULL)
+        fft_data[0] *= gain_bin(ctx, 0, y_ps[0], noise_ps[0]);
+
+    for (size_t i = 1; i <= last; ++i) {
+        y_ps[i] = fft_data[i] * fft_data[i] + fft_data[fft_size - i] * fft_data[fft_size - i];
+        norm += y_ps[i];
+        noise_ps[i] = noise_bin(state, i, y_ps[i], SNRseg, &norm_ns_ps);
+
+        if (gain_bin != NULL) {
+            gain = gain_bin(ctx, i, y_ps[i], noise_ps[i]);
+            fft_data[i] *= gain;
+            fft_data[fft_size - i] *= gain;
+        }
+    }
+
+    /* Nyquist bin, fft_size is even */
+    if (fft_size % 2 == 0) {
+        y_ps[fft_size / 2] = fft_data[fft_size / 2] * fft_data[fft_size / 2];
+        norm += y_ps[fft_size / 2];
+        noise_ps[fft_size / 2] = noise_bin(state, fft_size / 2, y_ps[fft_size / 2], SNRseg, &norm_ns_ps);
+        if (gain_bin != NULL)
+            fft_data[fft_size / 2] *= gain_bin(ctx, fft_size / 2, y_ps[fft_size / 2], noise_ps[fft_size / 2]);
+    }
+
+    state->n++;
+
+    *norm_ps = norm;
+    return norm_ns_ps;
+}
+
+/* apply gain to complex spectrum in one sweep over bins */
+static inline void gain_sweep(setk_context_t *ctx, real_t *fft_data, size_t fft_size, const real_t *y_ps,
+                              const real_t *noise_ps, gain_bin_func_t gain_bin) {
+    size_t last = (fft_size - 1) / 2; /* last bin with imaginary part */
+    real_t gain;
+
+    if (gain_bin == NULL)
+        return;
+
+    /* DC bin has no imaginary part */
+    fft_data[0] *= gain_bin(ctx, 0, y_ps[0], noise_ps[0]);
+
+    for (size_t i = 1; i <= last; ++i) {
+        gain = gain_bin(ctx, i, y_ps[i], noise_ps[i]);
+        fft_data[i] *= gain;
+        fft_data[fft_size - i] *= gain;
+    }
+
+    /* Nyquist bin, fft_size is even */
+    if (fft_size % 2 == 0)
+        fft_data[fft_size / 2] *= gain_bin(ctx, fft_size / 2, y_ps[fft_size / 2], noise_ps[fft_size / 2]);
+}
+
+void snd_enhance_residual(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                          fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate) {
+    /* initialize variables, per-frame buffers are taken from scratch arena */
+    setk_arena_t *scratch = &ctx->scratch;
+    uint64_t t; /* start of profiled stage */
+    real_t *y_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* power spectrum */
+    real_t *noise_ps = arena_alloc_real(scratch, fft_size / 2 + 1); /* noise power spectrum */
+    double norm_ps, norm_ns_ps;
+
+    /* FFT */
+    t = PROFILE_BEGIN(ctx->profile);
+    FFTW(execute_r2r)(fft_forw, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_FORW, t);
+
+    /* power spectrum, noise estimation and gain which turns magnitude spectrum into noise magnitude spectrum
+     * in one sweep, time of gain is part of noise estimation stage */
+    norm_ns_ps = estimate_spectra(ctx, fft_data, fft_size, noise_estimation, samplerate, y_ps, noise_ps, &norm_ps,
+                                  residual_gain_bin);
+    PROFILE_END(ctx->profile, PROFILE_NOISE_EST, t);
+
+    ctx->enh.SNRseg = calc_snr_seg(norm_ps, norm_ns_ps);
+    PROFILE_END(ctx->profile, PROFILE_GAIN, t);
 
     /* IFFT */
-    fftw_execute(fft_back);
+    FFTW(execute_r2r)(fft_back, fft_data, fft_data);
+    PROFILE_END(ctx->profile, PROFILE_FFT_BACK, t);
 
-    free(y_ps);
-    free(y_phase);
-    free(noise_ps);
+    arena_reset(scratch);
 }
@@ -8,31 +8,41 @@
 #ifndef HAVE_SND_ENHANCE_H
 #define HAVE_SND_ENHANCE_H
 
-#include <fftw3.h>
+#include "fft.h"
 #include "common.h"
+#include "context.h"
 #include "noise_est.h"
 
-typedef void (*snd_enh_func_t)(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                               noise_est_func_t noise_estimation, size_t datalen, int samplerate);
+typedef void (*snd_enh_func_t)(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                               fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate);
 
 extern snd_enh_func_t parse_snd_enhance_type(const char *name, bool verbose);
 
 extern char *get_snd_enhance_name(const char *name);
 
+/* algorithm keeps state between frames besides noise estimation, e.g. decision-directed a priori SNR */
+extern bool snd_enhance_has_state(snd_enh_func_t sound_enhancement);
+
+/* noise estimation of frame of window_size samples in fft_data without enhancement, e.g. first pass
+ * of two-pass mode, fft_data is transformed, noise_ps of fft_size / 2 + 1 bins is filled,
+ * returns its sum */
+extern double snd_enhance_estimate(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                                   noise_est_func_t noise_estimation, int samplerate, real_t *noise_ps);
+
 /* Sound Enhancement Algorithms */
-extern void snd_enhance_specsub(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                                noise_est_func_t noise_estimation, size_t datalen, int samplerate);
+extern void snd_enhance_specsub(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                                fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate);
 
-extern void snd_enhance_mmse(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                             noise_est_func_t noise_estimation, size_t datalen, int samplerate);
+extern void snd_enhance_mmse(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                             fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate);
 
-extern void snd_enhance_wiener_as(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                                  noise_est_func_t noise_estimation, size_t datalen, int samplerate);
+extern void snd_enhance_wiener_as(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                                  fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate);
 
-extern void snd_enhance_wiener_iter(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                                    noise_est_func_t noise_estimation, size_t datalen, int samplerate);
+extern void snd_enhance_wiener_iter(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                                    fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate);
 
-extern void snd_enhance_residual(double *fft_data, size_t fft_size, fftw_plan fft_forw, fftw_plan fft_back,
-                                 noise_est_func_t noise_estimation, size_t datalen, int samplerate);
+extern void snd_enhance_residual(setk_context_t *ctx, real_t *fft_data, size_t fft_size, fft_plan_t fft_forw,
+                                 fft_plan_t fft_back, noise_est_func_t noise_estimation, size_t datalen, int samplerate);
 
 #endif
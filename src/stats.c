@@ -0,0 +1,233 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* RTLD_DEFAULT */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <dlfcn.h>
+
+#include "stats.h"
+#include "i18n.h"
+
+/* print progress line */
+static void progress_print(const setk_progress_t *progress, sf_count_t frames, double now);
+
+/* write string as JSON string literal */
+static void json_string(FILE *file, const char *str);
+
+/* write number as JSON number, NaN and infinity are not valid JSON */
+static void json_number(FILE *file, double value);
+
+/* monotonic wall clock in seconds */
+double stats_wall_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* user and system time of process in seconds */
+double stats_cpu_time(void) {
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+           usage.ru_stime.tv_usec / 1e6;
+}
+
+/* peak resident set size of process in kilobytes, as reported by Linux */
+long stats_peak_rss(void) {
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return usage.ru_maxrss;
+}
+
+/* heap allocations of process counted by malloc interposer, every malloc of toolkit, libsndfile and FFTW
+ * goes through it, so that steady state can be proven to be allocation free */
+long stats_heap_allocations(void) {
+    static unsigned long (*malloc_count)(void) = NULL;
+    static bool resolved = false;
+
+    /* symbol is looked up once, lookup itself may allocate */
+    if (!resolved) {
+        malloc_count = (unsigned long (*)(void)) dlsym(RTLD_DEFAULT, "setk_malloc_count");
+        resolved = true;
+    }
+
+    return malloc_count != NULL ? (long) malloc_count() : -1;
+}
+
+/* start progress of file */
+void progress_start(setk_progress_t *progress, int interval_ms, int samplerate, sf_count_t total_frames) {
+    progress->samplerate = samplerate;
+    progress->total_frames = total_frames;
+    progress->start = stats_wall_clock();
+    progress->interval = interval_ms / 1000.0;
+    progress->next = progress->start + progress->interval;
+    progress->end = isatty(STDOUT_FILENO) ? '\r' : '\n';
+}
+
+/* print progress line, if interval has elapsed since the last one, clock is only read once per hop */
+void progress_update(setk_progress_t *progress, sf_count_t frames) {
+    double now;
+
+    if (progress->interval <= 0.0)
+        return;
+
+    if ((now = stats_wall_clock()) < progress->next)
+        return;
+
+    progress_print(progress, frames, now);
+    progress->next = now + progress->interval;
+}
+
+/* start progress of the same file again */
+void progress_restart(setk_progress_t *progress) {
+    progress->start = stats_wall_clock();
+    progress->next = progress->start + progress->interval;
+}
+
+/* print final progress line */
+void progress_finish(setk_progress_t *progress, sf_count_t frames) {
+    if (progress->interval <= 0.0)
+        return;
+
+    progress_print(progress, frames, stats_wall_clock());
+    if (progress->end == '\r')
+        putchar('\n');
+    fflush(stdout);
+}
+
+/* print progress line: position, length of input, speed and estimated time of arrival */
+static void progress_print(const setk_progress_t *progress, sf_count_t frames, double now) {
+    double elapsed = now - progress->start;
+    double speed = elapsed > 0.0 ? (double) frames / progress->samplerate / elapsed : 0.0;
+
+    /* show_time() returns static buffer, so every time is printed separately */
+    printf("%s", show_time(progress->samplerate, (int) frames));
+    if (progress->total_frames > 0)
+        printf(" / %s", show_time(progress->samplerate, (int) progress->total_frames));
+    printf(_("  %.1fx real-time"), speed);
+    if (progress->total_frames > 0 && speed > 0.0 && frames < progress->total_frames)
+        printf(_("  ETA %s"), show_time(progress->samplerate,
+                                        (int) ((progress->total_frames - frames) / speed)));
+    printf("%c", progress->end);
+    fflush(stdout);
+}
+
+/* write summary as JSON object into file or descriptor */
+int stats_write_json(const setk_run_stats_t *stats, const char *filename, int fd) {
+    double duration = (double) stats->frames / stats->samplerate;
+    FILE *file;
+    int status = 0;
+
+    /* descriptor belongs to caller, e.g. scheduler which started toolkit, so its copy is closed */
+    if (filename != NULL)
+        file = fopen(filename, "w");
+    else {
+        int copy = dup(fd);
+        file = copy < 0 ? NULL : fdopen(copy, "w");
+        if (file == NULL && copy >= 0)
+            close(copy);
+    }
+
+    if (file == NULL) {
+        if (filename != NULL)
+            printf(_("Error: Unable to open statistics file '%s': %s\n"), filename, strerror(errno));
+        else
+            printf(_("Error: Unable to write statistics to descriptor %d: %s\n"), fd, strerror(errno));
+        return 1;
+    }
+
+    fputs("{\n  \"input\": ", file);
+    json_string(file, stats->input_filename);
+    fputs(",\n  \"output\": ", file);
+    json_string(file, stats->output_filename);
+    fprintf(file, ",\n  \"samplerate\": %d", stats->samplerate);
+    fprintf(file, ",\n  \"channels\": %d", stats->channels);
+    fprintf(file, ",\n  \"frames\": %lld", (long long) stats->frames);
+    fputs(",\n  \"duration_seconds\": ", file);
+    json_number(file, duration);
+    fputs(",\n  \"wall_seconds\": ", file);
+    json_number(file, stats->wall_seconds);
+    fputs(",\n  \"cpu_seconds\": ", file);
+    json_number(file, stats->cpu_seconds);
+
+    /* real-time factor is processing time per second of processed audio, as in setk_bench */
+    fputs(",\n  \"rt_factor\": ", file);
+    json_number(file, duration > 0.0 ? stats->wall_seconds / duration : NAN);
+    fprintf(file, ",\n  \"peak_rss_kb\": %ld", stats->peak_rss_kb);
+
+    fputs(",\n  \"snr_seg_mean_db\": [", file);
+    for (int ch = 0; ch < stats->channels; ++ch) {
+        if (ch > 0)
+            fputs(", ", file);
+        json_number(file, stats->snr_seg[ch]);
+    }
+    fputs("]\n}\n", file);
+
+    if (ferror(file)) {
+        printf(_("Error: Unable to write statistics: %s\n"), strerror(errno));
+        status = 1;
+    }
+    if (fclose(file) != 0 && status == 0) {
+        printf(_("Error: Unable to write statistics: %s\n"), strerror(errno));
+        status = 1;
+    }
+
+    return status;
+}
+
+/* write string as JSON string literal, control characters are escaped */
+static void json_string(FILE *file, const char *str) {
+    if (str == NULL) {
+        fputs("null", file);
+        return;
+    }
+
+    fputc('"', file);
+    for (const unsigned char *c = (const unsigned char *) str; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\')
+            fprintf(file, "\\%c", *c);
+        else if (*c < 0x20)
+            fprintf(file, "\\u%04x", *c);
+        else
+            fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+/* write number as JSON number, NaN and infinity are written as null */
+static void json_number(FILE *file, double value) {
+    if (isfinite(value))
+        fprintf(file, "%.6g", value);
+    else
+        fputs("null", file);
+}
@@ -0,0 +1,67 @@
+/********************************************************************
+ function: Run statistics
+ contains: progress line throttled to wall clock interval and JSON
+           summary of processed file for job schedulers
+ ********************************************************************/
+
+#ifndef HAVE_STATS_H
+#define HAVE_STATS_H
+
+#include "common.h"
+
+/* default interval of progress line in milliseconds */
+#define PROGRESS_INTERVAL_DEFAULT           500
+
+/* progress of processed file, printed at most once per interval */
+typedef struct setk_progress_t {
+    int samplerate;
+    sf_count_t total_frames;                /* length of input, 0 when it is not known, e.g. stream */
+    double start;                           /* wall clock at start of processing */
+    double interval;                        /* seconds between progress lines, 0 disables progress */
+    double next;                            /* wall clock of next progress line */
+    char end;                               /* '\r' rewrites line on terminal, log gets one line each */
+} setk_progress_t;
+
+/* summary of processed file */
+typedef struct setk_run_stats_t {
+    const char *input_filename;
+    const char *output_filename;
+    int samplerate;
+    int channels;
+    sf_count_t frames;                      /* frames written to output */
+    double wall_seconds;
+    double cpu_seconds;                     /* user and system time of all threads */
+    long peak_rss_kb;
+    const double *snr_seg;                  /* mean segmental SNR in dB of every channel */
+} setk_run_stats_t;
+
+/* monotonic wall clock in seconds */
+extern double stats_wall_clock(void);
+
+/* user and system time of process in seconds */
+extern double stats_cpu_time(void);
+
+/* peak resident set size of process in kilobytes */
+extern long stats_peak_rss(void);
+
+/* heap allocations of process counted by malloc interposer, e.g. by malloc_count library of tests
+ * loaded by LD_PRELOAD, -1 when no interposer is loaded */
+extern long stats_heap_allocations(void);
+
+/* start progress of file, interval is given in milliseconds */
+extern void progress_start(setk_progress_t *progress, int interval_ms, int samplerate, sf_count_t total_frames);
+
+/* print progress line, if interval has elapsed since the last one */
+extern void progress_update(setk_progress_t *progress, sf_count_t frames);
+
+/* start progress of the same file again, e.g. for its next pass */
+extern void progress_restart(setk_progress_t *progress);
+
+/* print final progress line */
+extern void progress_finish(setk_progress_t *progress, sf_count_t frames);
+
+/* write summary as JSON object into file, or into descriptor fd when filename is NULL,
+ * descriptor is left open, returns 0 on success */
+extern int stats_write_json(const setk_run_stats_t *stats, const char *filename, int fd);
+
+#endif
@@ -0,0 +1,470 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "stream.h"
+#include "fft.h"
+#include "window.h"
+#include "noise_est.h"
+#include "snd_enhance.h"
+#include "i18n.h"
+
+/* enhance every full frame of buffer */
+static setk_status_t stream_process(setk_stream_t *stream);
+
+/* enhance frame at pos and queue output of its hop */
+static setk_status_t stream_hop(setk_stream_t *stream);
+
+/* make room for frames at end of output queue */
+static setk_status_t stream_reserve(setk_stream_t *stream, size_t frames);
+
+/* move frames from pos to start of buffer */
+static void stream_compact(setk_stream_t *stream);
+
+/* start new stream, output which was not pulled is kept */
+static void stream_restart(setk_stream_t *stream);
+
+/* set default options */
+void setk_stream_options_init(setk_stream_options_t *opts) {
+    memset((void *) opts, 0, sizeof(*opts));
+
+    opts->frame_duration = 20;
+    opts->fft_size = 0;
+    opts->overlap = 50;
+    opts->channel_threads = 1;
+}
+
+/* create stream, noise profile is loaded from opts->noise_profile */
+setk_status_t setk_stream_create(setk_stream_t **stream, int samplerate, int channels,
+                                 const setk_stream_options_t *opts) {
+    setk_noise_profile_t *noise_profile = NULL;
+    setk_status_t status;
+
+    if (stream == NULL)
+        return SETK_ERROR_ARGUMENT;
+
+    *stream = NULL;
+    if (opts != NULL && opts->noise_profile != NULL &&
+        (noise_profile = noise_profile_load(opts->noise_profile, false)) == NULL)
+        return SETK_ERROR_NOISE_PROFILE;
+
+    /* stream owns profile, processor keeps pointer to it */
+    if ((status = stream_create(stream, samplerate, channels, opts, noise_profile)) != SETK_OK)
+        noise_profile_destroy(noise_profile);
+    else
+        (*stream)->noise_profile = noise_profile;
+
+    return status;
+}
+
+/* create stream of noise profile loaded by caller */
+setk_status_t stream_create(setk_stream_t **stream, int samplerate, int channels,
+                            const setk_stream_options_t *opts, const setk_noise_profile_t *noise_profile) {
+    setk_stream_options_t defaults;
+    setk_stream_t *s;
+    noise_est_func_t noise_estimation;
+    const fft_plans_t *plans;
+    setk_status_t status;
+    int frame_duration;
+    size_t window_size, fft_size;
+
+    if (stream == NULL)
+        return SETK_ERROR_ARGUMENT;
+
+    *stream = NULL;
+    if (opts == NULL) {
+        setk_stream_options_init(&defaults);
+        opts = &defaults;
+    }
+
+    /* window size of longest frame must not overflow */
+    if (samplerate <= 0 || samplerate > INT_MAX / 30 || channels <= 0 || opts->frame_duration < 10 ||
+        opts->frame_duration > 30 || opts->fft_size > FFT_MAX || opts->overlap < 0 || opts->overlap > 99 ||
+        opts->channel_threads < 1 || opts->channel_threads > CHANNEL_THREADS_MAX)
+        return SETK_ERROR_ARGUMENT;
+
+    frame_duration = opts->frame_duration;
+    fft_size = opts->fft_size;
+    stream_frame_size(&frame_duration, samplerate, &window_size, &fft_size);
+
+    if (window_size == 0 || window_size > fft_size)
+        return SETK_ERROR_FRAME;
+
+    if ((s = (setk_stream_t *) calloc(1, sizeof(*s))) == NULL)
+        return SETK_ERROR_MEMORY;
+
+    s->samplerate = samplerate;
+    s->input_channels = channels;
+    s->channels = channels;
+
+    /* every stream has its own downmix, so streams may be pushed by parallel threads */
+    if (opts->downmix || opts->downmix_weights != NULL) {
+        if ((status = downmix_create(&s->downmix, channels, opts->downmix_weights)) != SETK_OK) {
+            free(s);
+            return status;
+        }
+        s->channels = 1;
+    }
+
+    noise_estimation = parse_noise_est_type(opts->noise_est_type, false);
+    if (noise_profile != NULL &&
+        noise_profile_check(noise_profile, get_noise_est_id(noise_estimation), samplerate, fft_size, s->channels,
+                            false) != 0) {
+        downmix_destroy(s->downmix);
+        free(s);
+        return SETK_ERROR_NOISE_PROFILE;
+    }
+
+    /* plans are shared by all streams, which execute them on their own buffers */
+    if ((plans = fft_plans_get(fft_size)) == NULL) {
+        setk_stream_destroy(s);
+        return SETK_ERROR_MEMORY;
+    }
+
+    if ((status = processor_create(&s->processor, fft_size, window_size, opts->overlap, s->channels, samplerate,
+                                   parse_window_type(opts->window_type, false),
+                                   parse_snd_enhance_type(opts->snd_enhance_type, false), noise_estimation,
+                                   plans->fft_forw, plans->fft_back, opts->channel_threads)) != SETK_OK) {
+        setk_stream_destroy(s);
+        return status;
+    }
+
+    /* noise estimation starts from profile, it is applied again whenever stream starts again */
+    if (noise_profile != NULL)
+        processor_set_noise_profile(s->processor, noise_profile);
+
+    s->capacity = STREAM_BLOCK_FRAMES + (sf_count_t) window_size;
+    s->output_capacity = STREAM_BLOCK_FRAMES + window_size;
+    s->buffer = (real_t *) malloc(sizeof(*s->buffer) * s->capacity * s->channels);
+    s->output = (real_t *) malloc(sizeof(*s->output) * s->output_capacity * s->channels);
+
+    if (s->buffer == NULL || s->output == NULL) {
+        setk_stream_destroy(s);
+        return SETK_ERROR_MEMORY;
+    }
+
+    *stream = s;
+
+    return SETK_OK;
+}
+
+/* push frames of interleaved data */
+setk_status_t setk_stream_push(setk_stream_t *stream, const setk_sample_t *data, size_t frames) {
+    setk_status_t status;
+    size_t count;
+
+    if (stream == NULL || (data == NULL && frames > 0))
+        return SETK_ERROR_ARGUMENT;
+
+    if (stream->flushed)
+        stream_restart(stream);
+
+    /* data is copied or mixed into buffer in blocks, every full frame is enhanced before next block */
+    while (frames > 0) {
+        if (stream->filled == stream->capacity)
+            stream_compact(stream);
+
+        count = MIN(frames, (size_t) (stream->capacity - stream->filled));
+        if (stream->downmix != NULL)
+            downmix_mix(stream->downmix, data, stream->buffer + stream->filled, count);
+        else
+            memcpy((void *) (stream->buffer + stream->filled * stream->channels), (void *) data,
+                   sizeof(*data) * count * stream->channels);
+
+        stream->filled += count;
+        stream->frames_in += count;
+        data += count * stream->input_channels;
+        frames -= count;
+
+        /* frames of data which were not pushed are lost, so stream starts again */
+        if ((status = stream_process(stream)) != SETK_OK) {
+            setk_stream_reset(stream);
+            return status;
+        }
+    }
+
+    return SETK_OK;
+}
+
+/* pull enhanced frames into data */
+size_t setk_stream_pull(setk_stream_t *stream, setk_sample_t *data, size_t frames) {
+    size_t count;
+
+    if (stream == NULL || data == NULL)
+        return 0;
+
+    count = MIN(frames, stream->output_end - stream->output_start);
+    memcpy((void *) data, (void *) (stream->output + stream->output_start * stream->channels),
+           sizeof(*data) * count * stream->channels);
+
+    /* empty queue starts at the beginning again, so it is moved only when output is not pulled */
+    stream->output_start += count;
+    if (stream->output_start == stream->output_end)
+        stream->output_start = stream->output_end = 0;
+
+    return count;
+}
+
+/* frames of output which are ready to be pulled */
+size_t setk_stream_available(const setk_stream_t *stream) {
+    return stream != NULL ? stream->output_end - stream->output_start : 0;
+}
+
+/* enhance zero padded tail of stream */
+setk_status_t setk_stream_flush(setk_stream_t *stream) {
+    sf_count_t window_size;
+    setk_status_t status;
+
+    if (stream == NULL)
+        return SETK_ERROR_ARGUMENT;
+
+    window_size = (sf_count_t) stream->processor->window_size;
+
+    /* frames after end of input are zero, hops are processed until output of every input frame is queued */
+    while (!stream->flushed && stream->frames_out < stream->frames_in) {
+        if (stream->pos + window_size > stream->filled) {
+            if (stream->pos + window_size > stream->capacity)
+                stream_compact(stream);
+
+            memset((void *) (stream->buffer + stream->filled * stream->channels), 0,
+                   sizeof(*stream->buffer) * (stream->pos + window_size - stream->filled) * stream->channels);
+            stream->filled = stream->pos + window_size;
+        }
+
+        if ((status = stream_hop(stream)) != SETK_OK) {
+            setk_stream_reset(stream);
+            return status;
+        }
+    }
+
+    stream->flushed = true;
+
+    return SETK_OK;
+}
+
+/* discard input and output of stream */
+void setk_stream_reset(setk_stream_t *stream) {
+    if (stream == NULL)
+        return;
+
+    stream_restart(stream);
+    stream->output_start = stream->output_end = 0;
+}
+
+/* channels of output */
+int setk_stream_channels(const setk_stream_t *stream) {
+    return stream != NULL ? stream->channels : 0;
+}
+
+/* frames of one frame */
+size_t setk_stream_window_size(const setk_stream_t *stream) {
+    return stream != NULL ? stream->processor->window_size : 0;
+}
+
+/* frames of one hop */
+size_t setk_stream_hop_size(const setk_stream_t *stream) {
+    return stream != NULL ? (size_t) stream->processor->nslide : 0;
+}
+
+/* mean segmental SNR of output channel */
+double setk_stream_snr_seg(const setk_stream_t *stream, int channel) {
+    if (stream == NULL || channel < 0 || channel >= stream->channels)
+        return 0.0;
+
+    return processor_mean_snr_seg(stream->processor, channel);
+}
+
+/* save state of noise estimation into file */
+setk_status_t setk_stream_save_noise_profile(const setk_stream_t *stream, const char *filename) {
+    const setk_processor_t *proc;
+    setk_noise_profile_t *saved;
+    setk_status_t status = SETK_OK;
+
+    if (stream == NULL || filename == NULL)
+        return SETK_ERROR_ARGUMENT;
+
+    proc = stream->processor;
+    if ((saved = noise_profile_create(get_noise_est_id(proc->noise_estimation), stream->samplerate,
+                                      proc->fft_size, stream->channels)) == NULL)
+        return SETK_ERROR_MEMORY;
+
+    processor_capture_noise_profile(proc, saved);
+    if (noise_profile_save(saved, filename, false) != 0)
+        status = SETK_ERROR_WRITE;
+    noise_profile_destroy(saved);
+
+    return status;
+}
+
+/* free stream */
+void setk_stream_destroy(setk_stream_t *stream) {
+    if (stream == NULL)
+        return;
+
+    processor_destroy(stream->processor);
+    downmix_destroy(stream->downmix);
+    noise_profile_destroy(stream->noise_profile);
+    free(stream->buffer);
+    free(stream->output);
+    free(stream);
+}
+
+/* free FFT plans and window tables */
+void setk_cleanup(void) {
+    fft_plans_cleanup();
+    window_tables_cleanup();
+}
+
+/* message of status */
+const char *setk_strerror(setk_status_t status) {
+    switch (status) {
+        case SETK_OK:
+            return _("No error");
+        case SETK_ERROR_ARGUMENT:
+            return _("Invalid argument or option out of range");
+        case SETK_ERROR_FRAME:
+            return _("Window of samplerate is empty or longer than FFT size");
+        case SETK_ERROR_DOWNMIX:
+            return _("Downmix weights do not match channels");
+        case SETK_ERROR_NOISE_PROFILE:
+            return _("Noise profile cannot be read or does not match stream");
+        case SETK_ERROR_MEMORY:
+            return _("Out of memory");
+        case SETK_ERROR_WRITE:
+            return _("Noise profile cannot be written");
+        case SETK_ERROR_THREAD:
+            return _("Channel thread cannot be created");
+    }
+
+    return _("Unknown error");
+}
+
+/* compute window and FFT size of samplerate from frame duration */
+void stream_frame_size(int *frame_duration, int samplerate, size_t *window_size, size_t *fft_size) {
+    do {
+
+        /* compute window size and make it even */
+        ((*window_size = WINDOW_SIZE (*frame_duration, samplerate)) % 2 != 0) ? *window_size += 1 : *window_size;
+
+        /* if computed optimal FFT size is greater than FFT_MAX, decrease
+         * frame_duration by one millisecond - repeated until FFT size <= FFT_MAX */
+        if (*fft_size == 0 || *fft_size > FFT_MAX) {
+            *fft_size = OPTIMAL_FFT_SIZE(*window_size);
+
+            if (*fft_size > FFT_MAX)
+                *frame_duration -= 1;
+        }
+
+    } while (*fft_size > FFT_MAX);
+}
+
+/* enhance every full frame of buffer */
+static setk_status_t stream_process(setk_stream_t *stream) {
+    sf_count_t window_size = (sf_count_t) stream->processor->window_size;
+    setk_status_t status;
+
+    while (stream->pos + window_size <= stream->filled) {
+        if ((status = stream_hop(stream)) != SETK_OK)
+            return status;
+    }
+
+    return SETK_OK;
+}
+
+/* enhance frame at pos, its first nslide frames are replaced with output, frames after end of input
+ * are dropped */
+static setk_status_t stream_hop(setk_stream_t *stream) {
+    int nslide = stream->processor->nslide;
+    size_t count = (size_t) MIN((sf_count_t) nslide, stream->frames_in - stream->frames_out);
+    real_t *frame = stream->buffer + stream->pos * stream->channels;
+    uint64_t t;
+
+    /* room is made before hop, so that output is never lost */
+    if (stream_reserve(stream, count) != SETK_OK)
+        return SETK_ERROR_MEMORY;
+
+    t = PROFILE_BEGIN(stream->profile);
+    processor_run(stream->processor, frame);
+    PROFILE_END(stream->profile, PROFILE_HOP, t);
+
+    memcpy((void *) (stream->output + stream->output_end * stream->channels), (void *) frame,
+           sizeof(*frame) * count * stream->channels);
+
+    stream->output_end += count;
+    stream->frames_out += count;
+    stream->pos += nslide;
+
+    return SETK_OK;
+}
+
+/* make room for frames at end of output queue, pulled frames are dropped first, queue grows only
+ * when it is full of output which was not pulled */
+static setk_status_t stream_reserve(setk_stream_t *stream, size_t frames) {
+    size_t pending = stream->output_end - stream->output_start;
+    size_t capacity;
+    real_t *output;
+
+    if (stream->output_end + frames <= stream->output_capacity)
+        return SETK_OK;
+
+    if (pending + frames <= stream->output_capacity) {
+        memmove((void *) stream->output, (void *) (stream->output + stream->output_start * stream->channels),
+                sizeof(*stream->output) * pending * stream->channels);
+    }
+    else {
+        capacity = MAX(2 * stream->output_capacity, pending + frames);
+        if ((output = (real_t *) malloc(sizeof(*output) * capacity * stream->channels)) == NULL)
+            return SETK_ERROR_MEMORY;
+
+        memcpy((void *) output, (void *) (stream->output + stream->output_start * stream->channels),
+               sizeof(*output) * pending * stream->channels);
+        free(stream->output);
+        stream->output = output;
+        stream->output_capacity = capacity;
+    }
+
+    stream->output_start = 0;
+    stream->output_end = pending;
+
+    return SETK_OK;
+}
+
+/* move frames from pos to start of buffer, this is less than one window per block */
+static void stream_compact(setk_stream_t *stream) {
+    sf_count_t remaining = stream->filled - stream->pos;
+
+    memmove((void *) stream->buffer, (void *) (stream->buffer + stream->pos * stream->channels),
+            sizeof(*stream->buffer) * remaining * stream->channels);
+
+    stream->filled = remaining;
+    stream->pos = 0;
+}
+
+/* start new stream, noise estimation starts from profile again */
+static void stream_restart(setk_stream_t *stream) {
+    processor_reset(stream->processor);
+
+    stream->filled = 0;
+    stream->pos = 0;
+    stream->frames_in = 0;
+    stream->frames_out = 0;
+    stream->flushed = false;
+}
@@ -0,0 +1,59 @@
+/********************************************************************
+ function: Stream
+ contains: implementation of libsetk stream, pushed frames are
+           collected in a buffer, every full frame is enhanced in
+           place by frame processor and output of its hop is queued
+           until it is pulled
+ ********************************************************************/
+
+#ifndef HAVE_STREAM_H
+#define HAVE_STREAM_H
+
+#include "setk.h"
+#include "common.h"
+#include "processor.h"
+#include "downmix.h"
+#include "noise_profile.h"
+#include "profile.h"
+
+/* frames of input buffer besides one window, output of push of this many frames fits into output queue
+ * of new stream, so that stream which is pulled after every push does not allocate */
+#define STREAM_BLOCK_FRAMES                 65536
+
+/* stream of libsetk, fields are used by toolkit, which processes mapped files by processor directly */
+struct setk_stream_t {
+    int samplerate;
+    int input_channels;                     /* channels of pushed frames */
+    int channels;                           /* channels of processor and output */
+    setk_processor_t *processor;
+    setk_downmix_t *downmix;                /* pushed frames are mixed to mono, or NULL */
+    setk_noise_profile_t *noise_profile;    /* loaded by setk_stream_create(), or NULL */
+    setk_profile_t *profile;                /* timing of hops, NULL when profiling is off */
+
+    /* interleaved frames of input, frame at pos is enhanced in place once it is filled */
+    real_t *buffer;
+    sf_count_t capacity;                    /* frames of buffer */
+    sf_count_t filled;                      /* frames of input and zero padding in buffer */
+    sf_count_t pos;                         /* first frame of next frame */
+
+    /* queue of interleaved output frames, which grows when output is not pulled */
+    real_t *output;
+    size_t output_capacity;                 /* frames of output queue */
+    size_t output_start;                    /* first frame which was not pulled */
+    size_t output_end;
+
+    sf_count_t frames_in;                   /* frames pushed since start of stream */
+    sf_count_t frames_out;                  /* frames of output since start of stream */
+    bool flushed;                           /* next push starts new stream */
+};
+
+/* compute window and FFT size of samplerate from frame duration, frame duration is shortened
+ * until FFT size fits into FFT_MAX, fft_size 0 is optimal size of window */
+extern void stream_frame_size(int *frame_duration, int samplerate, size_t *window_size, size_t *fft_size);
+
+/* create stream like setk_stream_create(), noise profile loaded by caller is used instead of
+ * opts->noise_profile, it is shared and it must stay valid until stream is destroyed */
+extern setk_status_t stream_create(setk_stream_t **stream, int samplerate, int channels,
+                                   const setk_stream_options_t *opts, const setk_noise_profile_t *noise_profile);
+
+#endif
@@ -9,4 +9,7 @@
 /* N is order of Bessel function, X is real number */
 extern double BESSI(int N, double X);
 
+/* exponentially scaled Bessel function EXP(-ABS(X)) * BESSI(N, X), does not overflow */
+extern double BESSIE(int N, double X);
+
 #endif
\ No newline at end of file
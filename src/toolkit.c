@@ -23,13 +23,23 @@
 #include <string.h>
 #include <math.h>
 #include <errno.h>
+#include <limits.h>
+#include <unistd.h>
 #include <getopt.h>
+#include <sys/stat.h>
 
 #include "config.h"
 #include "common.h"
 #include "toolkit.h"
 #include "snd_enhance.h"
 #include "window.h"
+#include "stream.h"
+#include "fft.h"
+#include "batch.h"
+#include "live.h"
+#include "stats.h"
+#include "framer.h"
+#include "segment.h"
 #include "i18n.h"
 
 static pl_rule setk_conf_rules[] = {
@@ -42,6 +52,31 @@ static pl_rule setk_conf_rules[] = {
         {"noise_estimation",  PLRT_STRING,  offsetof(setk_options_t, noise_est_type)},
         {"sound_enhancement", PLRT_STRING,  offsetof(setk_options_t, snd_enhance_type)},
         {"downmix",           PLRT_BOOL,    offsetof(setk_options_t, downmix)},
+        {"downmix_weights",   PLRT_STRING,  offsetof(setk_options_t, downmix_weights)},
+        {"segments",          PLRT_INTEGER, offsetof(setk_options_t, segments)},
+        {"segment_preroll",   PLRT_INTEGER, offsetof(setk_options_t, segment_preroll)},
+        {"two_pass",          PLRT_BOOL,    offsetof(setk_options_t, two_pass)},
+        {"noise_profile",     PLRT_STRING,  offsetof(setk_options_t, noise_profile_filename)},
+        {"save_noise_profile", PLRT_STRING, offsetof(setk_options_t, save_noise_profile_filename)},
+        {"channel_threads",   PLRT_INTEGER, offsetof(setk_options_t, channel_threads)},
+        {"batch",             PLRT_STRING,  offsetof(setk_options_t, batch_path)},
+        {"jobs",              PLRT_INTEGER, offsetof(setk_options_t, jobs)},
+        {"wisdom_file",       PLRT_STRING,  offsetof(setk_options_t, wisdom_filename)},
+        {"plan_effort",       PLRT_STRING,  offsetof(setk_options_t, plan_effort)},
+        {"raw_samplerate",    PLRT_INTEGER, offsetof(setk_options_t, raw_samplerate)},
+        {"raw_channels",      PLRT_INTEGER, offsetof(setk_options_t, raw_channels)},
+        {"live",              PLRT_BOOL,    offsetof(setk_options_t, live)},
+        {"live_source",       PLRT_STRING,  offsetof(setk_options_t, live_source)},
+        {"live_sink",         PLRT_STRING,  offsetof(setk_options_t, live_sink)},
+        {"live_samplerate",   PLRT_INTEGER, offsetof(setk_options_t, live_samplerate)},
+        {"live_channels",     PLRT_INTEGER, offsetof(setk_options_t, live_channels)},
+        {"live_duration",     PLRT_INTEGER, offsetof(setk_options_t, live_duration)},
+        {"async_io",          PLRT_BOOL,    offsetof(setk_options_t, async_io)},
+        {"mmap_io",           PLRT_BOOL,    offsetof(setk_options_t, mmap_io)},
+        {"profile",           PLRT_BOOL,    offsetof(setk_options_t, profile)},
+        {"progress_interval", PLRT_INTEGER, offsetof(setk_options_t, progress_interval)},
+        {"stats_file",        PLRT_STRING,  offsetof(setk_options_t, stats_filename)},
+        {"stats_fd",          PLRT_INTEGER, offsetof(setk_options_t, stats_fd)},
         {"verbose",           PLRT_BOOL,    offsetof(setk_options_t, verbosity)},
         {NULL,                PLRT_END, 0},
 };
@@ -57,20 +92,44 @@ static const struct option long_options[] = {
         {"snd-enhance", required_argument, NULL, ARG_SND_ENH},
         {"version",     no_argument,       NULL, ARG_VERSION},
         {"downmix",     no_argument,       NULL, ARG_DOWNMIX},
+        {"downmix-weights", required_argument, NULL, ARG_DOWNMIX_WEIGHTS},
+        {"segments",    required_argument, NULL, ARG_SEGMENTS},
+        {"segment-preroll", required_argument, NULL, ARG_SEGMENT_PREROLL},
+        {"two-pass",    no_argument,       NULL, ARG_TWO_PASS},
+        {"noise-profile", required_argument, NULL, ARG_NOISE_PROFILE},
+        {"save-noise-profile", required_argument, NULL, ARG_SAVE_NOISE_PROFILE},
+        {"channel-threads", required_argument, NULL, ARG_CHANNEL_THREADS},
+        {"batch",       required_argument, NULL, ARG_BATCH},
+        {"jobs",        required_argument, NULL, ARG_JOBS},
+        {"wisdom",      required_argument, NULL, ARG_WISDOM},
+        {"plan-effort", required_argument, NULL, ARG_PLAN_EFFORT},
+        {"prewarm-wisdom", no_argument,    NULL, ARG_PREWARM_WISDOM},
+        {"raw-samplerate", required_argument, NULL, ARG_RAW_SAMPLERATE},
+        {"raw-channels", required_argument, NULL, ARG_RAW_CHANNELS},
+        {"live",        no_argument,       NULL, ARG_LIVE},
+        {"live-source", required_argument, NULL, ARG_LIVE_SOURCE},
+        {"live-sink",   required_argument, NULL, ARG_LIVE_SINK},
+        {"live-samplerate", required_argument, NULL, ARG_LIVE_SAMPLERATE},
+        {"live-channels", required_argument, NULL, ARG_LIVE_CHANNELS},
+        {"live-duration", required_argument, NULL, ARG_LIVE_DURATION},
+        {"async-io",    no_argument,       NULL, ARG_ASYNC_IO},
+        {"no-mmap",     no_argument,       NULL, ARG_NO_MMAP},
+        {"profile",     no_argument,       NULL, ARG_PROFILE},
+        {"progress-interval", required_argument, NULL, ARG_PROGRESS_INTERVAL},
+        {"stats",       required_argument, NULL, ARG_STATS},
+        {"stats-fd",    required_argument, NULL, ARG_STATS_FD},
         {"verbose",     no_argument,       NULL, 'v'},
         {"config",      required_argument, NULL, 'c'},
         {"help",        no_argument,       NULL, 'h'},
         {NULL,          no_argument,       NULL, 0}
 };
 
-typedef sf_count_t (*snd_read_func_t)(SNDFILE *file, double *data, sf_count_t datalen);
+/* descriptor of standard output, when audio is written to stdout, messages are redirected to stderr */
+static int stream_output_fd = -1;
 
 /* read configuration from file */
 static int load_config(const char *filename, setk_options_t *args);
 
-/* output file name was not specified */
-static const char *create_output_file_name(const char *input_filename);
-
 /* check_int_range */
 static void check_int_range(const char *name, int value, int lower, int upper);
 
@@ -80,12 +139,24 @@ static void parse_arguments(setk_options_t *args);
 /* parse configuration file */
 static int parse_line(char *line, const char *split, pl_rule *rules, void *data);
 
-/* process audio file */
+/* process audio file or batch of files */
 static void process_audio(setk_options_t *args);
 
+/* pull output of stream into blocks of framer */
+static int write_output(setk_stream_t *stream, setk_framer_t *framer);
+
 /* print file info */
 static void file_info(setk_options_t *args, SF_INFO info);
 
+/* file name refers to stdin or stdout */
+static bool is_stream(const char *filename);
+
+/* open input file or stdin */
+static SNDFILE *open_input(const setk_options_t *args, SF_INFO *info);
+
+/* open output file or stdout */
+static SNDFILE *open_output(const setk_options_t *args, SF_INFO *info);
+
 /* Print usage */
 static void help(const char *argv0) {
 
@@ -98,7 +169,18 @@ static void help(const char *argv0) {
 
                            "  -c, --config                Custom configuration from file\n\n"
 
-                           "  -v, --verbose               Enable verbose operations\n\n"
+                           "  -v, --verbose               Enable verbose operations\n"
+                           "      --profile               Print time spent in every processing stage: total,\n"
+                           "                              mean, p50, p99 and max per frame, and real-time\n"
+                           "                              headroom per hop, not available in batch mode\n"
+                           "      --progress-interval     Milliseconds between progress lines, default 500,\n"
+                           "                              '0' disables progress\n"
+                           "      --stats                 Write JSON summary of run into file: frames, wall\n"
+                           "                              and CPU time, real-time factor, peak memory and\n"
+                           "                              mean segmental SNR of every channel\n"
+                           "      --stats-fd              Write JSON summary into open file descriptor,\n"
+                           "                              e.g. pipe of job scheduler, not available in batch\n"
+                           "                              mode as --stats\n\n"
 
                            "      --input                 Input file name\n"
                            "      --output                Output file name\n\n"
@@ -106,6 +188,30 @@ static void help(const char *argv0) {
                            "                              If no output file name is given,\n"
                            "                              it is created based on input file name\n\n"
 
+                           "                              Name '-' reads audio from stdin or writes it to stdout,\n"
+                           "                              output on stdout is headerless PCM and all messages\n"
+                           "                              are printed to stderr\n"
+                           "      --raw-samplerate        Input is headerless 16 bit PCM with this samplerate,\n"
+                           "                              e.g. raw stream on stdin\n"
+                           "      --raw-channels          Number of channels of headerless input, range <1 - 64>,\n"
+                           "                              default 1\n\n"
+
+                           "      --live                  Capture from PulseAudio source, enhance in real time\n"
+                           "                              and play back to PulseAudio sink, latency, overruns\n"
+                           "                              and underruns are reported at the end\n"
+                           "      --live-source           PulseAudio source, default source if not given\n"
+                           "      --live-sink             PulseAudio sink, default sink if not given\n"
+                           "      --live-samplerate       Samplerate of live stream, default 16000 Hz\n"
+                           "      --live-channels         Channels of live stream, range <1 - 32>, default 1\n"
+                           "      --live-duration         Stop after given number of seconds, default 0 runs\n"
+                           "                              until Ctrl+C\n\n"
+
+                           "      --batch                 Process all files of a directory or of a list file\n"
+                           "                              with one file name per line. Output is written into\n"
+                           "                              --output directory, or next to the input file.\n"
+                           "      --jobs                  Number of files processed in parallel in batch mode,\n"
+                           "                              range <1 - 64>, default 1\n\n"
+
                            "      --frame-dur             Duration of speech frame in milliseconds,\n"
                            "                              range <10 - 30> ms\n\n"
 
@@ -117,6 +223,41 @@ static void help(const char *argv0) {
 
                            "      --downmix               Downmix multichannel audio to mono\n\n"
 
+                           "      --downmix-weights       Comma separated weights of channels in downmix,\n"
+                           "                              e.g. '0.7,0.3', implies --downmix, default mean\n\n"
+
+                           "      --segments              Number of segments of one file processed in parallel,\n"
+                           "                              range <1 - 64>, default 1, only memory mapped files\n"
+                           "                              are split, other files are processed in one pass\n"
+                           "                              with a warning, not available with hirsch noise\n"
+                           "                              estimation\n"
+                           "      --segment-preroll       Warm-up of noise estimation before every segment\n"
+                           "                              in milliseconds, range <0 - 60000>, default 2000\n"
+                           "      --noise-profile         Start noise estimation from state saved by\n"
+                           "                              --save-noise-profile, e.g. from recording of noise\n"
+                           "                              of the same line or microphone\n"
+                           "      --save-noise-profile    Save state of noise estimation after the last frame\n\n"
+
+                           "      --two-pass              Estimate noise of whole file first, then enhance it\n"
+                           "                              in segments in parallel, one per processor unless\n"
+                           "                              --segments is set, output of specsub, wiener-iter\n"
+                           "                              and residual is the same as in one pass\n\n"
+
+                           "      --channel-threads       Number of threads processing channels in parallel,\n"
+                           "                              range <1 - 64>, default 1\n\n"
+
+                           "      --async-io              Decode input and encode output on separate threads,\n"
+                           "                              which overlap e.g. FLAC or Ogg codecs with processing\n"
+                           "      --no-mmap               Read and write all files with libsndfile, by default\n"
+                           "                              16 or 24 bit PCM and float WAV or raw files are memory\n"
+                           "                              mapped and converted without copies\n\n"
+
+                           "      --wisdom                FFTW wisdom cache file, it is loaded on start and\n"
+                           "                              updated when new FFT plans were measured\n"
+                           "      --plan-effort           FFT planning effort: estimate, measure or patient,\n"
+                           "                              default measure\n"
+                           "      --prewarm-wisdom        Plan every FFT size, save wisdom and exit\n\n"
+
                            "      --noise-est             Type of noise estimation algorithm\n\n"
 
                            "      --snd-enhance           Type of sound enhancement algorithm\n\n"
@@ -171,6 +312,33 @@ int main(int argc, char **argv) {
             .noise_est_type = NULL,
             .snd_enhance_type = NULL,
             .downmix = false,
+            .downmix_weights = NULL,
+            .segments = 1,
+            .segment_preroll = SEGMENT_PREROLL_DEFAULT,
+            .two_pass = false,
+            .noise_profile_filename = NULL,
+            .save_noise_profile_filename = NULL,
+            .noise_profile = NULL,
+            .channel_threads = 1,
+            .batch_path = NULL,
+            .jobs = 1,
+            .wisdom_filename = NULL,
+            .plan_effort = NULL,
+            .prewarm_wisdom = false,
+            .raw_samplerate = 0,
+            .raw_channels = 1,
+            .live = false,
+            .live_source = NULL,
+            .live_sink = NULL,
+            .live_samplerate = LIVE_SAMPLERATE_DEFAULT,
+            .live_channels = 1,
+            .live_duration = 0,
+            .async_io = false,
+            .mmap_io = true,
+            .profile = false,
+            .progress_interval = PROGRESS_INTERVAL_DEFAULT,
+            .stats_filename = NULL,
+            .stats_fd = -1,
             .verbosity = false,
             .window_size = 0,
     };
@@ -204,6 +372,24 @@ int main(int argc, char **argv) {
             case ARG_VERSION:
                 printf(_("Sound Enhancement Toolkit Version %d.%d\n"), snd_tk_VERSION_MAJOR, snd_tk_VERSION_MINOR);
                 break;
+            case ARG_ASYNC_IO:  /* decoding and encoding on I/O threads */
+                opts.async_io = true;
+                break;
+            case ARG_NO_MMAP:   /* libsndfile for all files */
+                opts.mmap_io = false;
+                break;
+            case ARG_PROFILE:   /* stage timing */
+                opts.profile = true;
+                break;
+            case ARG_PROGRESS_INTERVAL:
+                opts.progress_interval = atoi(optarg);
+                break;
+            case ARG_STATS:
+                opts.stats_filename = optarg;
+                break;
+            case ARG_STATS_FD:
+                opts.stats_fd = atoi(optarg);
+                break;
             case 'v':   /* verbose mode */
                 opts.verbosity = true;
                 break;
@@ -216,6 +402,66 @@ int main(int argc, char **argv) {
             case ARG_DOWNMIX: /* downmix to mono */
                 opts.downmix = true;
                 break;
+            case ARG_DOWNMIX_WEIGHTS: /* weighted downmix to mono */
+                opts.downmix_weights = optarg;
+                break;
+            case ARG_SEGMENTS: /* parallel segments of one file */
+                opts.segments = atoi(optarg);
+                break;
+            case ARG_SEGMENT_PREROLL: /* warm-up of segment */
+                opts.segment_preroll = atoi(optarg);
+                break;
+            case ARG_TWO_PASS: /* noise estimation before enhancement */
+                opts.two_pass = true;
+                break;
+            case ARG_NOISE_PROFILE: /* initial state of noise estimation */
+                opts.noise_profile_filename = optarg;
+                break;
+            case ARG_SAVE_NOISE_PROFILE: /* final state of noise estimation */
+                opts.save_noise_profile_filename = optarg;
+                break;
+            case ARG_CHANNEL_THREADS: /* parallel channel processing */
+                opts.channel_threads = atoi(optarg);
+                break;
+            case ARG_BATCH: /* list file or directory */
+                opts.batch_path = optarg;
+                break;
+            case ARG_JOBS: /* batch workers */
+                opts.jobs = atoi(optarg);
+                break;
+            case ARG_WISDOM: /* FFTW wisdom cache */
+                opts.wisdom_filename = optarg;
+                break;
+            case ARG_PLAN_EFFORT: /* FFTW planner flags */
+                opts.plan_effort = optarg;
+                break;
+            case ARG_PREWARM_WISDOM: /* plan all FFT sizes */
+                opts.prewarm_wisdom = true;
+                break;
+            case ARG_RAW_SAMPLERATE: /* headerless input */
+                opts.raw_samplerate = atoi(optarg);
+                break;
+            case ARG_RAW_CHANNELS:
+                opts.raw_channels = atoi(optarg);
+                break;
+            case ARG_LIVE: /* PulseAudio capture and playback */
+                opts.live = true;
+                break;
+            case ARG_LIVE_SOURCE:
+                opts.live_source = optarg;
+                break;
+            case ARG_LIVE_SINK:
+                opts.live_sink = optarg;
+                break;
+            case ARG_LIVE_SAMPLERATE:
+                opts.live_samplerate = atoi(optarg);
+                break;
+            case ARG_LIVE_CHANNELS:
+                opts.live_channels = atoi(optarg);
+                break;
+            case ARG_LIVE_DURATION:
+                opts.live_duration = atoi(optarg);
+                break;
             case ARG_WINDOW_TYPE: /* window function type */
                 opts.window_type = optarg;
                 break;
@@ -257,8 +503,18 @@ static int load_config(const char *filename, setk_options_t *args) {
     return 0;
 }
 
+/* both names refer to the same file, device and inode are compared */
+bool is_same_file(const char *filename1, const char *filename2) {
+    struct stat st1, st2;
+
+    if (stat(filename1, &st1) != 0 || stat(filename2, &st2) != 0)
+        return strcmp(filename1, filename2) == 0;
+
+    return st1.st_dev == st2.st_dev && st1.st_ino == st2.st_ino;
+}
+
 /* no output file was specified, append _enhanced.[extension] to input file name */
-static const char *create_output_file_name(const char *input_filename) {
+const char *create_output_file_name(const char *input_filename) {
     char *tmp_name = alloca((strlen(input_filename) + 10) * sizeof(*tmp_name));
     char *p_ext = NULL;
     const char *output_filename = NULL;
@@ -295,6 +551,58 @@ static void parse_arguments(setk_options_t *args) {
     check_int_range("frame duration", args->frame_duration, 10, 30);
     check_int_range("fft size", (int) args->fft_size, 0, FFT_MAX);
     check_int_range("overlap percentage", args->overlap, 0, 99);
+    check_int_range("channel threads", args->channel_threads, 1, CHANNEL_THREADS_MAX);
+    check_int_range("jobs", args->jobs, 1, BATCH_JOBS_MAX);
+    check_int_range("raw samplerate", args->raw_samplerate, 0, INT_MAX);
+    check_int_range("raw channels", args->raw_channels, 1, RAW_CHANNELS_MAX);
+    check_int_range("live samplerate", args->live_samplerate, 1, LIVE_SAMPLERATE_MAX);
+    check_int_range("live channels", args->live_channels, 1, LIVE_CHANNELS_MAX);
+    check_int_range("live duration", args->live_duration, 0, INT_MAX);
+    check_int_range("progress interval", args->progress_interval, 0, INT_MAX);
+    check_int_range("statistics descriptor", args->stats_fd, -1, INT_MAX);
+    check_int_range("segments", args->segments, 1, SEGMENTS_MAX);
+    check_int_range("segment pre-roll", args->segment_preroll, 0, SEGMENT_PREROLL_MAX);
+
+    /* weights are only used by downmix, their count is checked against channels of every file */
+    if (args->downmix_weights != NULL)
+        args->downmix = true;
+
+    if (args->prewarm_wisdom && args->wisdom_filename == NULL) {
+        puts(_("Error: No wisdom file was specified."));
+        exit(1);
+    }
+
+    /* summary describes one processed file */
+    if ((args->stats_filename != NULL || args->stats_fd >= 0) &&
+        (args->batch_path != NULL || args->prewarm_wisdom || args->live)) {
+        puts(_("Error: Statistics are only available when a single file is processed."));
+        exit(1);
+    }
+
+    /* batch is parallel over files, live stream cannot be split */
+    if ((args->segments > 1 || args->two_pass) && (args->batch_path != NULL || args->prewarm_wisdom || args->live)) {
+        puts(_("Error: Segments and two-pass mode are only available when a single file is processed."));
+        exit(1);
+    }
+
+    /* noise decision of hirsch has hysteresis, so its estimate after pre-roll never meets one pass,
+     * noise track of two-pass mode is estimated in one pass */
+    if (args->segments > 1 && !args->two_pass &&
+        parse_noise_est_type(args->noise_est_type, false) == hirsch_estimation) {
+        puts(_("Error: Segments are not available with hirsch noise estimation unless two-pass mode is set."));
+        exit(1);
+    }
+
+    /* profile is the state after the last frame of one file */
+    if (args->save_noise_profile_filename != NULL &&
+        (args->batch_path != NULL || args->prewarm_wisdom || args->live || args->segments > 1 || args->two_pass)) {
+        puts(_("Error: Noise profile is only saved when a single file is processed in one pass."));
+        exit(1);
+    }
+
+    /* in batch mode, output file name is the name of output directory, live mode has no files */
+    if (args->batch_path != NULL || args->prewarm_wisdom || args->live)
+        return;
 
     /* no input file was specified */
     if (args->input_filename == NULL) {
@@ -302,169 +610,384 @@ static void parse_arguments(setk_options_t *args) {
         exit(1);
     }
 
-    /* no output file was specified, append _enhanced.[extension] to input file name */
+    /* no output file was specified, append _enhanced.[extension] to input file name,
+     * stdin is enhanced to stdout */
     if (args->output_filename == NULL)
-        args->output_filename = create_output_file_name(args->input_filename);
+        args->output_filename = is_stream(args->input_filename) ? STREAM_NAME :
+                                create_output_file_name(args->input_filename);
 
-    /* input and output file names are the same */
-    if (strcmp(args->input_filename, args->output_filename) == 0) {
-        puts(_("Error: input and output file names are the same."));
+    /* input and output are the same file, output would be truncated before it is read */
+    if (!is_stream(args->input_filename) && is_same_file(args->input_filename, args->output_filename)) {
+        puts(_("Error: input and output are the same file."));
         exit(1);
     }
 }
 
-/* process audio file */
+/* process audio file or batch of files */
 static void process_audio(setk_options_t *args) {
+    unsigned plan_flags = FFTW_MEASURE;
+    int status;
+
     /* parse command line arguments */
     parse_arguments(args);
 
-    /* initialize variables */
-    snd_enh_func_t sound_enhancement;
-    noise_est_func_t noise_estimation;
-    window_func_t window_function;
+    if (args->plan_effort != NULL && fft_parse_plan_effort(args->plan_effort, &plan_flags) != 0) {
+        printf(_("Error: Unknown FFT planning effort '%s'.\n"), args->plan_effort);
+        exit(1);
+    }
+    fft_set_plan_flags(plan_flags);
+
+    /* profile is shared by all files of batch */
+    if (args->noise_profile_filename != NULL && !args->prewarm_wisdom &&
+        (args->noise_profile = noise_profile_load(args->noise_profile_filename, true)) == NULL)
+        exit(1);
+
+    if (args->wisdom_filename != NULL && fft_wisdom_import(args->wisdom_filename) != 0 && args->verbosity)
+        printf(_("FFTW wisdom '%s' was not loaded, FFT plans will be measured.\n"), args->wisdom_filename);
+
+    /* audio is written to stdout, so messages are moved to stderr, they would corrupt the stream */
+    if (args->batch_path == NULL && !args->prewarm_wisdom && !args->live && is_stream(args->output_filename)) {
+        fflush(stdout);
+        if ((stream_output_fd = dup(STDOUT_FILENO)) < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+            printf(_("Error: Unable to redirect standard output: %s\n"), strerror(errno));
+            exit(1);
+        }
+    }
+
+    if (args->prewarm_wisdom) {
+        fft_plans_prewarm(args->fft_size);
+        status = 0;
+    }
+    else if (args->live) {
+#ifdef HAVE_PULSEAUDIO
+        status = process_live(args);
+#else
+        puts(_("Error: Live mode is not available, toolkit was built without PulseAudio."));
+        status = 1;
+#endif
+    }
+    else if (args->batch_path != NULL)
+        status = process_batch(args);
+    else
+        status = process_file(args, args->input_filename, args->output_filename, NULL);
 
+    if (args->wisdom_filename != NULL && fft_wisdom_export(args->wisdom_filename) != 0)
+        status = 1;
 
+    setk_cleanup();
+    noise_profile_destroy(args->noise_profile);
+
+    if (status != 0)
+        exit(1);
+}
+
+/* process one audio file */
+int process_file(const setk_options_t *opts, const char *input_filename, const char *output_filename,
+                 setk_stream_t **cache) {
+    /* every file may have different samplerate, so window and fft size are computed on a copy of options */
+    setk_options_t file_opts = *opts;
+    setk_options_t *args = &file_opts;
+
+    /* initialize variables */
     SNDFILE *input_file, *output_file;
     SF_INFO info;
-    snd_read_func_t sndfile_read;
-    int noverlap, nslide;
-    sf_count_t count, frames_read = 0;
-    double *multi_data, *prev_multi_data, *window;
-    double *fft_data, *es_old_multi;
-    double winGain;
-    sndfile_read = sf_readf_double;
+    setk_stream_options_t stream_opts;
+    setk_stream_t *stream = NULL;
+    setk_status_t stream_status = SETK_OK;
+    int input_channels;
+    int status = 0;
+    bool batch = (cache != NULL);
+    long steady_allocations = -1;           /* heap allocations after first block, -1 when they are not counted */
+    bool first_block = true;
+    sf_count_t frames_written = 0;
+    setk_profile_t *profile = NULL;
+    setk_progress_t progress;
+    double wall_start = stats_wall_clock(), cpu_start = stats_cpu_time();
+    setk_framer_t *framer;
+    framer_io_t io = {NULL};
+    const real_t *block;
+    sf_count_t frames;
+    mapped_tags_t tags = {
+            .title = output_filename,
+            .comment = "Enhanced audio signal",
+            .software = "Sound Enhancement Toolkit",
+            .copyright = "No copyright.",
+    };
+
+    args->input_filename = input_filename;
+    args->output_filename = output_filename;
 
     /* open input file */
-    if ((input_file = sf_open(args->input_filename, SFM_READ, &info)) == NULL) {
+    if ((input_file = open_input(args, &info)) == NULL) {
         printf(_("Error: Unable to open input file '%s': %s\n"), args->input_filename, sf_strerror(NULL));
-        sf_close(input_file);
-        exit(1);
+        return 1;
     }
 
-    do {
-
-        /* compute window size and make it even */
-        (((args->window_size) = WINDOW_SIZE (args->frame_duration, info.samplerate)) % 2 != 0)
-        ? (args->window_size) += 1 : (args->window_size);
-
-        /* if computed optimal FFT size is greater than FFT_MAX, decrease
-         * frame_duration by one millisecond - repeated until FFT size <= FFT_MAX */
-        if ((args->fft_size) == 0 || (args->fft_size) > FFT_MAX) {
-            args->fft_size = OPTIMAL_FFT_SIZE(args->window_size);
-
-            if ((args->fft_size) > FFT_MAX)
-                args->frame_duration -= 1;
-        }
+    /* uncompressed PCM file is converted straight from its map, libsndfile has only parsed its header */
+    if (args->mmap_io && !is_stream(args->input_filename))
+        io.mapped_input = mapped_open_input(args->input_filename, &info);
 
-    } while ((args->fft_size) > FFT_MAX);
+    compute_frame_size(args, info.samplerate);
 
-    /* Force output to mono. */
-    if ((args->downmix)) {
+    /* Force output to mono, stream mixes channels of input */
+    input_channels = info.channels;
+    if ((args->downmix))
         info.channels = 1;
-        sndfile_read = sfx_mix_mono_read_double;
-    }
 
     /* print file info */
-    if (args->verbosity)
+    if (args->verbosity && !batch) {
         file_info(args, info);
 
-    /* open output file */
-    if ((output_file = sf_open(args->output_filename, SFM_WRITE, &info)) == NULL) {
-        printf(_("Error: Unable to open output file '%s': %s\n"), args->output_filename, sf_strerror(NULL));
-        sf_close(output_file);
-        exit(1);
+        /* stream selects the same algorithms, defaults are only reported here */
+        parse_window_type(args->window_type, true);
+        parse_snd_enhance_type(args->snd_enhance_type, true);
+        parse_noise_est_type(args->noise_est_type, true);
     }
 
-    if ((args->window_size) > (args->fft_size)) {
-        printf(_("%s : Error: Size of FFT is less than window size\n"), __func__);
-        exit(1);
+    /* previous file of batch had the same format, options are the same for all files, so its stream
+     * only starts again */
+    if (batch && *cache != NULL) {
+        stream = *cache;
+        *cache = NULL;
+        if (stream->samplerate == info.samplerate && stream->input_channels == input_channels) {
+            setk_stream_reset(stream);
+        }
+        else {
+            setk_stream_destroy(stream);
+            stream = NULL;
+        }
     }
 
-    /* write info tag into audio file */
-    sf_set_string(output_file, SF_STR_TITLE, args->output_filename);
-    sf_set_string(output_file, SF_STR_COMMENT, "Enhanced audio signal");
-    sf_set_string(output_file, SF_STR_SOFTWARE, "Sound Enhancement Toolkit");
-    sf_set_string(output_file, SF_STR_COPYRIGHT, "No copyright.");
+    /* every file has its own stream, so files of batch may be processed in parallel, loaded noise profile
+     * is shared by all of them */
+    if (stream == NULL) {
+        stream_options(args, &stream_opts);
+        stream_status = stream_create(&stream, info.samplerate, input_channels, &stream_opts, args->noise_profile);
+        if (stream_status != SETK_OK) {
+            stream_error(args, stream_status, info.samplerate, input_channels);
+            mapped_close(io.mapped_input);
+            sf_close(input_file);
+            return 1;
+        }
+    }
 
-    noverlap = (int) floor((args->window_size) * (args->overlap) / 100);
-    nslide = (int) (args->window_size) - noverlap;
+    /* output has the same length as input, so output of mapped input is preallocated and mapped too */
+    output_file = NULL;
+    if (io.mapped_input != NULL && !is_stream(args->output_filename))
+        io.mapped_output = mapped_create_output(args->output_filename, &info, io.mapped_input->frames, &tags);
 
-    multi_data = init_buffer_dbl((size_t) (args->window_size) * info.channels);
-    prev_multi_data = init_buffer_dbl((size_t) noverlap * info.channels);
-    es_old_multi = init_buffer_dbl((size_t) nslide * info.channels);
+    /* open output file */
+    if (io.mapped_output == NULL && (output_file = open_output(args, &info)) == NULL) {
+        printf(_("Error: Unable to open output file '%s': %s\n"), args->output_filename, sf_strerror(NULL));
+        setk_stream_destroy(stream);
+        mapped_close(io.mapped_input);
+        sf_close(input_file);
+        return 1;
+    }
 
-    /* Window function */
-    window_function = parse_window_type(args->window_type, args->verbosity);
-    window = init_buffer_dbl(args->window_size);
+    /* write info tag into audio file, mapped output has them in its header */
+    if (output_file != NULL) {
+        sf_set_string(output_file, SF_STR_TITLE, tags.title);
+        sf_set_string(output_file, SF_STR_COMMENT, tags.comment);
+        sf_set_string(output_file, SF_STR_SOFTWARE, tags.software);
+        sf_set_string(output_file, SF_STR_COPYRIGHT, tags.copyright);
+    }
 
-    /* Sound enhancement algorithm */
-    sound_enhancement = parse_snd_enhance_type(args->snd_enhance_type, args->verbosity);
+    /* stage timing, processor times its channels and stream its hops */
+    if (args->profile && !batch && (profile = profile_create()) != NULL) {
+        processor_enable_profile(stream->processor);
+        stream->profile = profile;
+    }
 
-    /* Noise estimation algorithm */
-    noise_estimation = parse_noise_est_type(args->noise_est_type, args->verbosity);
+    /* progress is throttled to wall clock interval, length of input is only known for files */
+    progress_start(&progress, batch ? 0 : args->progress_interval, info.samplerate,
+                   is_stream(args->input_filename) || args->raw_samplerate > 0 ? 0 : info.frames);
+
+    /* segments read and write their parts of mapped files at once by processor of stream,
+     * other files are processed in one pass */
+    if ((args->segments > 1 || args->two_pass) && io.mapped_output != NULL) {
+        if (args->two_pass)
+            frames_written = process_two_pass(args, stream->processor, io.mapped_input, stream->downmix,
+                                              io.mapped_output, &progress, profile);
+        else
+            frames_written = process_segments(args, args->segments, stream->processor, io.mapped_input,
+                                              stream->downmix, io.mapped_output, NULL, &progress, profile);
+
+        if (frames_written < 0) {
+            frames_written = 0;
+            status = 1;
+        }
+        progress_finish(&progress, frames_written);
+    }
+    else {
+        /* file is still enhanced, but neither in parallel nor with noise of whole file, so it is
+         * reported every time */
+        if (args->two_pass)
+            printf(_("Warning: Input or output of '%s' can not be memory mapped, it is processed in one pass "
+                     "instead of two.\n"), args->input_filename);
+        else if (args->segments > 1)
+            printf(_("Warning: Input or output of '%s' can not be memory mapped, it is processed in one pass "
+                     "instead of %d segments.\n"), args->input_filename, args->segments);
+
+        /* input is read in blocks, which are pushed to stream, its output is pulled into blocks of output,
+         * input is never sought and its length is not needed */
+        io.input = input_file;
+        io.output = output_file;
+        if ((framer = framer_create(&io, input_channels, info.channels, args->async_io, profile)) == NULL) {
+            printf(_("Error: Unable to create I/O buffers or threads of '%s'.\n"), args->input_filename);
+            status = 1;
+        }
+        else {
+            while ((frames = framer_read(framer, &block)) > 0) {
+                progress_update(&progress, framer->frames_read);
+
+                if ((stream_status = setk_stream_push(stream, block, (size_t) frames)) != SETK_OK ||
+                    write_output(stream, framer) != 0)
+                    break;
+
+                /* buffers of all algorithms exist after the first block, steady state must not allocate,
+                 * allocations are only counted when malloc interposer is loaded */
+                if (first_block) {
+                    steady_allocations = stats_heap_allocations();
+                    first_block = false;
+                }
+            }
 
-    /* fft transform data */
-    fft_data = init_buffer_dbl(args->fft_size);
+            /* the last hops flush overlap of zero padded tail, output has the same length as input */
+            if (stream_status == SETK_OK && !framer->write_failed &&
+                (stream_status = setk_stream_flush(stream)) == SETK_OK)
+                write_output(stream, framer);
 
-    fftw_plan fft_forw = fftw_plan_r2r_1d((int) args->fft_size, fft_data, fft_data, FFTW_R2HC, FFTW_MEASURE);
-    fftw_plan fft_back = fftw_plan_r2r_1d((int) args->fft_size, fft_data, fft_data, FFTW_HC2R, FFTW_MEASURE);
+            /* I/O threads are joined, empty input is an error as well */
+            framer_finish(framer);
+            frames_written = framer->frames_written;
+            progress_finish(&progress, frames_written);
 
-    do {
-        if (frames_read == 0) {
-            if ((count = sndfile_read(input_file, multi_data, (int) args->window_size)) <= 0)
-                exit(1);
-            memcpy((void *) prev_multi_data, (void *) (multi_data + nslide * info.channels),
-                   sizeof(*multi_data) * noverlap * info.channels);
-        }
-        else {
-            count = sndfile_read(input_file, (multi_data + noverlap * info.channels), nslide);
-            memcpy((void *) multi_data, (void *) prev_multi_data, sizeof(*prev_multi_data) * noverlap * info.channels);
-            memcpy((void *) prev_multi_data, (void *) (multi_data + nslide * info.channels),
-                   sizeof(*multi_data) * noverlap * info.channels);
+            if (framer->read_failed || framer->frames_read == 0) {
+                printf(_("Error: Unable to read input file '%s': %s\n"), args->input_filename,
+                       sf_strerror(input_file));
+                status = 1;
+            }
+            if (framer->write_failed) {
+                /* mapped output only fails when it is full */
+                printf(_("Error: Unable to write output file '%s': %s\n"), args->output_filename,
+                       output_file != NULL ? sf_strerror(output_file) : strerror(ENOSPC));
+                status = 1;
+            }
+            if (stream_status != SETK_OK) {
+                printf(_("Error: %s.\n"), setk_strerror(stream_status));
+                status = 1;
+            }
+            framer_destroy(framer);
         }
+    }
 
-        frames_read += count;
-        printf("%s\r", show_time(info.samplerate, (int) frames_read));
+    if (args->verbosity && !batch) {
+        puts(_("\nFinished audio processing."));
+        if (steady_allocations >= 0)
+            printf(_("Heap allocations after first block: %ld\n"), stats_heap_allocations() - steady_allocations);
+    }
 
-        for (int ch = 0; ch < info.channels; ++ch) {
-            memset(fft_data, 0, sizeof(*fft_data) * (args->fft_size)); /* initialize fft array to zero values */
+    if (profile != NULL) {
+        processor_collect_profile(stream->processor, profile);
+        profile_report(profile, (double) setk_stream_hop_size(stream) / info.samplerate);
+        profile_destroy(profile);
+        stream->profile = NULL;
+    }
 
-            separate_channels_double(multi_data, fft_data, (int) args->window_size, info.channels, ch);
+    /* state after the last frame, e.g. of recording of noise of line, is initial state of other files */
+    if (args->save_noise_profile_filename != NULL &&
+        (stream_status = setk_stream_save_noise_profile(stream, args->save_noise_profile_filename)) != SETK_OK) {
+        printf(_("Error: %s: '%s'\n"), setk_strerror(stream_status), args->save_noise_profile_filename);
+        status = 1;
+    }
 
-            winGain = apply_window(fft_data, args->window_size, window_function);
-            winGain = nslide / winGain;
+    if (!batch && (args->stats_filename != NULL || args->stats_fd >= 0)) {
+        double snr_seg[info.channels];
+        setk_run_stats_t stats = {
+                .input_filename = args->input_filename,
+                .output_filename = args->output_filename,
+                .samplerate = info.samplerate,
+                .channels = info.channels,
+                .frames = frames_written,
+                .wall_seconds = stats_wall_clock() - wall_start,
+                .cpu_seconds = stats_cpu_time() - cpu_start,
+                .peak_rss_kb = stats_peak_rss(),
+                .snr_seg = snr_seg,
+        };
+
+        for (int ch = 0; ch < info.channels; ++ch)
+            snr_seg[ch] = setk_stream_snr_seg(stream, ch);
+
+        if (stats_write_json(&stats, args->stats_filename, args->stats_fd) != 0)
+            status = 1;
+    }
 
-            sound_enhancement(fft_data, args->fft_size, fft_forw, fft_back, noise_estimation, args->window_size,
-                              info.samplerate);
+    if (batch)
+        *cache = stream;
+    else
+        setk_stream_destroy(stream);
 
-            /* Add-and-Overlap */
-            for (int i = 0; i < nslide; ++i) {
-                fft_data[i] = winGain * (fft_data[i] / (args->fft_size) + es_old_multi[ch * nslide + i]);
-            }
+    if (mapped_close(io.mapped_output) != 0) {
+        printf(_("Error: Unable to write output file '%s': %s\n"), args->output_filename, strerror(errno));
+        status = 1;
+    }
+    mapped_close(io.mapped_input);
+    if (output_file != NULL)
+        sf_close(output_file);
+    sf_close(input_file);
 
-            for (int i = 0; i < nslide; ++i) {
-                es_old_multi[ch * nslide + i] = fft_data[i + noverlap] / (args->fft_size);
-            }
+    return status;
+}
 
-            combine_channels_double(multi_data, fft_data, nslide, info.channels, ch);
-        }
+/* options of stream of file or of live stream */
+void stream_options(const setk_options_t *args, setk_stream_options_t *opts) {
+    setk_stream_options_init(opts);
+
+    opts->snd_enhance_type = args->snd_enhance_type;
+    opts->noise_est_type = args->noise_est_type;
+    opts->window_type = args->window_type;
+    opts->frame_duration = args->frame_duration;
+    opts->fft_size = args->fft_size;
+    opts->overlap = args->overlap;
+    opts->channel_threads = args->channel_threads;
+    opts->downmix = args->downmix;
+    opts->downmix_weights = args->downmix_weights;
+}
 
-        sf_writef_double(output_file, multi_data, nslide);
-    } while (count > 0);
+/* print error of stream creation, mismatch of downmix weights or of noise profile is explained */
+void stream_error(const setk_options_t *args, setk_status_t status, int samplerate, int channels) {
+    const char *estimator = get_noise_est_id(parse_noise_est_type(args->noise_est_type, false));
+
+    if (status == SETK_ERROR_DOWNMIX)
+        printf(_("Error: Downmix weights '%s' do not match %d channels of input.\n"), args->downmix_weights,
+               channels);
+    else if (status != SETK_ERROR_NOISE_PROFILE || args->noise_profile == NULL ||
+             noise_profile_check(args->noise_profile, estimator, samplerate, args->fft_size,
+                                 args->downmix ? 1 : channels, true) == 0)
+        printf(_("Error: %s.\n"), setk_strerror(status));
+}
 
-    if (args->verbosity)
-        puts(_("\n\nFinished audio processing."));
+/* pull output of stream into blocks of framer, returns 0 when all of it was written */
+static int write_output(setk_stream_t *stream, setk_framer_t *framer) {
+    real_t *output;
+    size_t frames;
 
-    fftw_destroy_plan(fft_forw);
-    fftw_destroy_plan(fft_back);
-    free(fft_data);
-    free(multi_data);
-    free(prev_multi_data);
-    free(es_old_multi);
-    free(window);
-    sf_close(output_file);
-    sf_close(input_file);
+    while (setk_stream_available(stream) > 0) {
+        if ((output = framer_output(framer)) == NULL)
+            return 1;
 
+        frames = setk_stream_pull(stream, output, FRAMER_BLOCK_FRAMES);
+        if (framer_write(framer, (sf_count_t) frames) != 0)
+            return 1;
+    }
+
+    return 0;
+}
+
+/* compute window and FFT size of samplerate from frame duration */
+void compute_frame_size(setk_options_t *args, int samplerate) {
+    stream_frame_size(&args->frame_duration, samplerate, &args->window_size, &args->fft_size);
 }
 
 /* print file info */
@@ -474,11 +997,26 @@ static void file_info(setk_options_t *args, SF_INFO info) {
     printf(_("-----------------------------------------\n"));
     printf(_("Input File: %s\n"), args->input_filename);
     printf(_("Output File: %s\n"), args->output_filename);
-    printf(_("Duration: %s\n"), show_time(info.samplerate, info.frames));
+    if (is_stream(args->input_filename) || args->raw_samplerate > 0)
+        printf(_("Duration: unknown\n"));
+    else
+        printf(_("Duration: %s\n"), show_time(info.samplerate, info.frames));
     printf(_("Samplerate: %d Hz\n"), info.samplerate);
     printf(_("Channels: %d\n"), info.channels);
     printf(_("-----------------------------------------\n"));
     printf(_("Downmix to mono: %s\n"), istrue_bool(args->downmix));
+    if (args->downmix_weights != NULL)
+        printf(_("Downmix Weights: %s\n"), args->downmix_weights);
+    printf(_("Segments: %d\n"), args->segments);
+    if (args->segments > 1 || args->two_pass)
+        printf(_("Segment Pre-roll: %d ms\n"), args->segment_preroll);
+    printf(_("Two-pass: %s\n"), istrue_bool(args->two_pass));
+    if (args->noise_profile_filename != NULL)
+        printf(_("Noise Profile: %s\n"), args->noise_profile_filename);
+    printf(_("Channel Threads: %d\n"), args->channel_threads);
+    printf(_("Asynchronous I/O: %s\n"), istrue_bool(args->async_io));
+    printf(_("Memory Mapped I/O: %s\n"), istrue_bool(args->mmap_io));
+    printf(_("Precision: %s\n"), sizeof(real_t) == sizeof(float) ? _("single") : _("double"));
     printf(_("Frame Duration: %d ms\n"), args->frame_duration);
     printf(_("Overlap: %d %%\n"), args->overlap);
     printf(_("Window Size: %d samples\n"), (int) args->window_size);
@@ -489,9 +1027,43 @@ static void file_info(setk_options_t *args, SF_INFO info) {
     printf(_("-----------------------------------------\n\n"));
 }
 
+/* file name refers to stdin or stdout */
+static bool is_stream(const char *filename) {
+    return strcmp(filename, STREAM_NAME) == 0;
+}
+
+/* open input file or stdin, headerless input is described by raw options */
+static SNDFILE *open_input(const setk_options_t *args, SF_INFO *info) {
+    memset((void *) info, 0, sizeof(*info));
+
+    if (args->raw_samplerate > 0) {
+        info->samplerate = args->raw_samplerate;
+        info->channels = args->raw_channels;
+        info->format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+    }
+
+    if (is_stream(args->input_filename))
+        return sf_open_fd(STDIN_FILENO, SFM_READ, info, 0);
+
+    return sf_open(args->input_filename, SFM_READ, info);
+}
+
+/* open output file or stdout, header of WAV and most other formats can not be completed on a pipe,
+ * so stdout gets headerless PCM of input sample format */
+static SNDFILE *open_output(const setk_options_t *args, SF_INFO *info) {
+    if (!is_stream(args->output_filename))
+        return sf_open(args->output_filename, SFM_WRITE, info);
+
+    info->format = SF_FORMAT_RAW | (info->format & SF_FORMAT_SUBMASK);
+    if (!sf_format_check(info))
+        info->format = SF_FORMAT_RAW | SF_FORMAT_PCM_16;
+
+    return sf_open_fd(stream_output_fd, SFM_WRITE, info, 0);
+}
+
 /* parse configuration file */
 static int parse_line(char *line, const char *split, pl_rule *rules, void *data) {
-    unsigned int r, len;
+    unsigned int r;
     char *end = NULL, *val = NULL, *p = NULL;
     void *store;
 
@@ -517,7 +1089,8 @@ static int parse_line(char *line, const char *split, pl_rule *rules, void *data)
     end = &line[strlen(line) - 1];
     /* Skip until whitespace */
     while (p < end &&
-           strncmp(p, split, strlen(split)) != 0)
+           strncmp(p, split, strlen(split)) != 0 &&
+           *p != '\t')
         p++;
     /* Terminate this argument */
     *p = '\0';
@@ -525,8 +1098,8 @@ static int parse_line(char *line, const char *split, pl_rule *rules, void *data)
 
     /* Skip whitespace */
     while (p < end &&
-           *p == ' ' &&
-           *p == '\t')
+           (*p == ' ' ||
+            *p == '\t'))
         p++;
 
     /* Start of the value */
@@ -547,10 +1120,10 @@ static int parse_line(char *line, const char *split, pl_rule *rules, void *data)
     }
     /* Otherwise it is already terminated above */
 
-    /* Walk through all the rules */
+    /* Walk through all the rules, key is compared whole, as some keys start with another key,
+     * e.g. downmix_weights and downmix */
     for (r = 0; rules[r].type != PLRT_END; ++r) {
-        len = (int) strlen(rules[r].title);
-        if (strncmp(line, rules[r].title, len) != 0) continue;
+        if (strcmp(line, rules[r].title) != 0) continue;
 
         store = (void *) ((char *) data + rules[r].offset);
 
@@ -1,6 +1,9 @@
 #ifndef HAVE_TOOLKIT_H
 #define HAVE_TOOLKIT_H
 
+#include "common.h"
+#include "stream.h"
+
 #ifndef offsetof
 #define offsetof(TYPE, MEMBER) ((size_t) &((TYPE *)0)->MEMBER)
 #endif
@@ -19,6 +22,32 @@ enum setk_arguments_t {
     ARG_NOISE_EST,
     ARG_SND_ENH,
     ARG_DOWNMIX,
+    ARG_DOWNMIX_WEIGHTS,
+    ARG_SEGMENTS,
+    ARG_SEGMENT_PREROLL,
+    ARG_TWO_PASS,
+    ARG_NOISE_PROFILE,
+    ARG_SAVE_NOISE_PROFILE,
+    ARG_CHANNEL_THREADS,
+    ARG_BATCH,
+    ARG_JOBS,
+    ARG_WISDOM,
+    ARG_PLAN_EFFORT,
+    ARG_PREWARM_WISDOM,
+    ARG_RAW_SAMPLERATE,
+    ARG_RAW_CHANNELS,
+    ARG_LIVE,
+    ARG_LIVE_SOURCE,
+    ARG_LIVE_SINK,
+    ARG_LIVE_SAMPLERATE,
+    ARG_LIVE_CHANNELS,
+    ARG_LIVE_DURATION,
+    ARG_ASYNC_IO,
+    ARG_NO_MMAP,
+    ARG_PROFILE,
+    ARG_PROGRESS_INTERVAL,
+    ARG_STATS,
+    ARG_STATS_FD,
     ARG_INPUT_FILE,
     ARG_OUTPUT_FILE,
     ARG_FRAME_DURATION,
@@ -51,9 +80,68 @@ typedef struct setk_global_args_t {
     /* --estimate option       */
     const char *snd_enhance_type;       /* --enhance option        */
     bool downmix;                        /* --downmix option        */
+    const char *downmix_weights;         /* --downmix-weights option */
+    int segments;                        /* --segments option       */
+    int segment_preroll;                 /* --segment-preroll option */
+    bool two_pass;                       /* --two-pass option       */
+    const char *noise_profile_filename;  /* --noise-profile option  */
+    const char *save_noise_profile_filename; /* --save-noise-profile option */
+    setk_noise_profile_t *noise_profile;  /* loaded --noise-profile  */
+    int channel_threads;                 /* --channel-threads option */
+    const char *batch_path;              /* --batch option          */
+    int jobs;                            /* --jobs option           */
+    const char *wisdom_filename;         /* --wisdom option         */
+    const char *plan_effort;             /* --plan-effort option    */
+    bool prewarm_wisdom;                 /* --prewarm-wisdom option */
+    int raw_samplerate;                  /* --raw-samplerate option */
+    int raw_channels;                    /* --raw-channels option   */
+    bool live;                           /* --live option           */
+    const char *live_source;             /* --live-source option    */
+    const char *live_sink;               /* --live-sink option      */
+    int live_samplerate;                 /* --live-samplerate option */
+    int live_channels;                   /* --live-channels option  */
+    int live_duration;                   /* --live-duration option  */
+    bool async_io;                       /* --async-io option       */
+    bool mmap_io;                        /* --no-mmap option        */
+    bool profile;                        /* --profile option        */
+    int progress_interval;               /* --progress-interval option */
+    const char *stats_filename;          /* --stats option          */
+    int stats_fd;                        /* --stats-fd option       */
     bool verbosity;
     /* -v or --verbose option  */
     size_t window_size;                     /* size of window          */
 } setk_options_t;
 
+/* file name of standard input or output stream */
+#define STREAM_NAME                         "-"
+
+/* maximum number of channels of headerless input */
+#define RAW_CHANNELS_MAX                    64
+
+/* limits of live stream, as in PulseAudio */
+#define LIVE_SAMPLERATE_MAX                 384000
+#define LIVE_CHANNELS_MAX                   32
+
+/* output file name was not specified, append _enhanced.[extension] to input file name */
+extern const char *create_output_file_name(const char *input_filename);
+
+/* both names refer to the same file, e.g. through links or other paths, names of files which
+ * do not exist yet are compared */
+extern bool is_same_file(const char *filename1, const char *filename2);
+
+/* compute window and FFT size of samplerate from frame duration, frame duration is shortened
+ * until FFT size fits into FFT_MAX */
+extern void compute_frame_size(setk_options_t *args, int samplerate);
+
+/* process one audio file, stream in *cache is reused if it has the same format,
+ * cache is NULL when single file is processed */
+extern int process_file(const setk_options_t *opts, const char *input_filename, const char *output_filename,
+                        setk_stream_t **cache);
+
+/* options of libsetk stream of file or of live stream, noise profile is passed to stream_create() */
+extern void stream_options(const setk_options_t *args, setk_stream_options_t *opts);
+
+/* print error of stream creation of samplerate and channels of input */
+extern void stream_error(const setk_options_t *args, setk_status_t status, int samplerate, int channels);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "track.h"
+#include "i18n.h"
+
+/* create track of hops of channels */
+setk_track_t *track_create(sf_count_t hops, int channels, size_t bins) {
+    size_t entries = (size_t) hops * channels;
+    size_t norm_bytes = sizeof(double) * entries;
+    size_t length = norm_bytes + sizeof(real_t) * entries * bins;
+    setk_track_t *track;
+    FILE *file;
+    void *map;
+
+    /* file is removed on close, its pages are written back only under memory pressure */
+    if ((file = tmpfile()) == NULL)
+        return NULL;
+
+    if (ftruncate(fileno(file), (off_t) length) != 0 ||
+        (map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(file), 0)) == MAP_FAILED) {
+        fclose(file);
+        return NULL;
+    }
+
+    /* mapping keeps file alive */
+    fclose(file);
+
+    if ((track = (setk_track_t *) calloc(1, sizeof(*track))) == NULL) {
+        munmap(map, length);
+        return NULL;
+    }
+
+    /* norms come first, so that spectra are aligned as well */
+    track->hops = hops;
+    track->channels = channels;
+    track->bins = bins;
+    track->map = map;
+    track->length = length;
+    track->norm_ns_ps = (double *) map;
+    track->noise_ps = (real_t *) ((unsigned char *) map + norm_bytes);
+
+    return track;
+}
+
+/* unmap track, its file was removed when it was created */
+void track_destroy(setk_track_t *track) {
+    if (track == NULL)
+        return;
+
+    munmap(track->map, track->length);
+    free(track);
+}
@@ -0,0 +1,42 @@
+/********************************************************************
+ function: Noise Track
+ contains: noise power spectrum and its norm of every frame and
+           channel, computed by the first pass of two-pass mode and
+           kept in a temporary file, so long recordings do
+           not have to fit into memory
+ ********************************************************************/
+
+#ifndef HAVE_TRACK_H
+#define HAVE_TRACK_H
+
+#include "common.h"
+
+/* noise estimate of hops of one stream, hop h of channel ch is stored at h * channels + ch */
+typedef struct setk_track_t {
+    sf_count_t hops;
+    int channels;
+    size_t bins;                            /* fft_size / 2 + 1 */
+    real_t *noise_ps;                       /* noise power spectra, bins per hop and channel */
+    double *norm_ns_ps;                     /* sums of noise power spectra */
+    void *map;
+    size_t length;                          /* bytes of map */
+} setk_track_t;
+
+/* create track of hops of channels, pages are backed by temporary file,
+ * returns NULL when the file cannot be created or mapped or track cannot be allocated */
+extern setk_track_t *track_create(sf_count_t hops, int channels, size_t bins);
+
+/* noise power spectrum of hop and channel */
+static inline real_t *track_noise_ps(const setk_track_t *track, sf_count_t hop, int ch) {
+    return track->noise_ps + ((size_t) hop * track->channels + ch) * track->bins;
+}
+
+/* sum of noise power spectrum of hop and channel */
+static inline double *track_norm_ns_ps(const setk_track_t *track, sf_count_t hop, int ch) {
+    return track->norm_ns_ps + (size_t) hop * track->channels + ch;
+}
+
+/* unmap track, its file is removed */
+extern void track_destroy(setk_track_t *track);
+
+#endif
@@ -8,9 +8,15 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <errno.h>
+#include <pthread.h>
 #include "window.h"
 #include "i18n.h"
 
+/* window tables are shared between threads */
+static pthread_mutex_t window_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static window_table_t *window_tables = NULL;
+
 window_func_t parse_window_type(const char *name, bool verbose) {
     if (name == NULL) {
         if (verbose)
@@ -59,30 +65,61 @@ char *get_window_name(const char *name) {
     return (_("Hamming window (default)"));
 }
 
-/* apply_window */
-double apply_window(double *data, size_t datalen, window_func_t calc_window) {
-    static double window[WINDOW_MAX];
-    static size_t window_len = 0;
-    static double winGain;
-
-    if (window_len != datalen) {
-        window_len = datalen;
-        if (datalen > ARRAY_LEN (window)) {
-            printf(_("%s : datalen >  MAX_HEIGHT\n"), __func__);
-            exit(1);
-        };
-
-        winGain = calc_window(window, datalen);
-    };
+/* get window table */
+const window_table_t *get_window_table(window_func_t calc_window, size_t datalen) {
+    window_table_t *table;
+
+    pthread_mutex_lock(&window_tables_lock);
+
+    for (table = window_tables; table != NULL; table = table->next) {
+        if (table->calc_window == calc_window && table->datalen == datalen) {
+            pthread_mutex_unlock(&window_tables_lock);
+            return table;
+        }
+    }
+
+    /* table is cached only when it is complete */
+    if ((table = (window_table_t *) malloc(sizeof(*table))) == NULL ||
+        (table->window = init_buffer_real(datalen)) == NULL) {
+        free(table);
+        pthread_mutex_unlock(&window_tables_lock);
+        return NULL;
+    }
+
+    table->calc_window = calc_window;
+    table->datalen = datalen;
+    table->win_gain = calc_window(table->window, datalen);
+    table->next = window_tables;
+    window_tables = table;
+
+    pthread_mutex_unlock(&window_tables_lock);
 
+    return table;
+}
+
+/* free all window tables */
+void window_tables_cleanup(void) {
+    window_table_t *table;
+
+    pthread_mutex_lock(&window_tables_lock);
+
+    while ((table = window_tables) != NULL) {
+        window_tables = table->next;
+        free(table->window);
+        free(table);
+    }
+
+    pthread_mutex_unlock(&window_tables_lock);
+}
+
+/* apply_window */
+void apply_window(real_t *data, const real_t *window, size_t datalen) {
     for (size_t n = 0; n < datalen; ++n)
         data[n] *= window[n];
-
-    return winGain;
 }
 
 /* hamming window */
-double calc_hamming_window(double *data, size_t datalen) {
+double calc_hamming_window(real_t *data, size_t datalen) {
     double winGain = 0.0;
 
     for (size_t n = 0; n < datalen; ++n) {
@@ -94,7 +131,7 @@ double calc_hamming_window(double *data, size_t datalen) {
 }
 
 /* hann window */
-double calc_hann_window(double *data, size_t datalen) {
+double calc_hann_window(real_t *data, size_t datalen) {
     double winGain = 0.0;
 
     for (size_t n = 0; n < datalen; ++n) {
@@ -106,7 +143,7 @@ double calc_hann_window(double *data, size_t datalen) {
 }
 
 /* blackman window */
-double calc_blackman_window(double *data, size_t datalen) {
+double calc_blackman_window(real_t *data, size_t datalen) {
     double winGain = 0.0;
 
     for (size_t n = 0; n < datalen; n++) {
@@ -119,7 +156,7 @@ double calc_blackman_window(double *data, size_t datalen) {
 }
 
 /* bartlett window */
-double calc_bartlett_window(double *data, size_t datalen) {
+double calc_bartlett_window(real_t *data, size_t datalen) {
     double winGain = 0.0;
 
     for (size_t n = 0; n < datalen; ++n) {
@@ -146,7 +183,7 @@ double calc_bartlett_window(double *data, size_t datalen) {
 }
 
 /* triangular window */
-double calc_triangular_window(double *data, size_t datalen) {
+double calc_triangular_window(real_t *data, size_t datalen) {
     double winGain = 0.0;
 
     for (size_t n = 0; n < datalen; ++n) {
@@ -173,7 +210,7 @@ double calc_triangular_window(double *data, size_t datalen) {
 }
 
 /* rectangular window */
-double calc_rectangular_window(double *data, size_t datalen) {
+double calc_rectangular_window(real_t *data, size_t datalen) {
     double winGain = 0.0;
 
     for (size_t n = 0; n < datalen; ++n) {
@@ -185,7 +222,7 @@ double calc_rectangular_window(double *data, size_t datalen) {
 }
 
 /* nuttall_window */
-double calc_nuttall_window(double *data, size_t datalen) {
+double calc_nuttall_window(real_t *data, size_t datalen) {
     const double a[4] = {0.355768, 0.487396, 0.144232, 0.012604};
     double scale;
     double winGain = 0.0;
@@ -11,7 +11,16 @@
 
 #include "common.h"
 
-typedef double (*window_func_t)(double *data, size_t datalen);
+typedef double (*window_func_t)(real_t *data, size_t datalen);
+
+/* calculated window function, shared by all streams with the same window */
+typedef struct window_table_t {
+    window_func_t calc_window;
+    size_t datalen;
+    real_t *window;
+    double win_gain;                        /* sum of window coefficients */
+    struct window_table_t *next;
+} window_table_t;
 
 /* parse window type */
 extern window_func_t parse_window_type(const char *name, bool verbose);
@@ -19,21 +28,27 @@ extern window_func_t parse_window_type(const char *name, bool verbose);
 /* get window name */
 char *get_window_name(const char *name);
 
-/* apply_window */
-extern double apply_window(double *data, size_t datalen, window_func_t calc_window);
+/* get window table, it is calculated on first use, NULL when it cannot be allocated */
+extern const window_table_t *get_window_table(window_func_t calc_window, size_t datalen);
+
+/* free all window tables */
+extern void window_tables_cleanup(void);
+
+/* apply_window, window table is calculated by one of window functions below */
+extern void apply_window(real_t *data, const real_t *window, size_t datalen);
 
-extern double calc_hamming_window(double *data, size_t datalen);
+extern double calc_hamming_window(real_t *data, size_t datalen);
 
-extern double calc_hann_window(double *data, size_t datalen);
+extern double calc_hann_window(real_t *data, size_t datalen);
 
-extern double calc_blackman_window(double *data, size_t datalen);
+extern double calc_blackman_window(real_t *data, size_t datalen);
 
-extern double calc_bartlett_window(double *data, size_t datalen);
+extern double calc_bartlett_window(real_t *data, size_t datalen);
 
-extern double calc_triangular_window(double *data, size_t datalen);
+extern double calc_triangular_window(real_t *data, size_t datalen);
 
-extern double calc_rectangular_window(double *data, size_t datalen);
+extern double calc_rectangular_window(real_t *data, size_t datalen);
 
-extern double calc_nuttall_window(double *data, size_t datalen);
+extern double calc_nuttall_window(real_t *data, size_t datalen);
 
 #endif
@@ -0,0 +1,101 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* compare samples of two audio files, headers are not compared, difference is measured in least
+ * significant bits of sample format of the first file, files differ when its maximum or its root
+ * mean square exceeds tolerance */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sndfile.h>
+
+/* frames compared at once */
+#define BLOCK_FRAMES                        4096
+
+int main(int argc, char **argv) {
+    SF_INFO info[2];
+    SNDFILE *file[2];
+    int block[2][BLOCK_FRAMES * 8];
+    long tolerance, diff, max_diff = 0;
+    double rms_tolerance, rms, sum_squares = 0.0;
+    sf_count_t frames[2], pos = 0, max_pos = 0;
+    int shift;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s FILE1 FILE2 [TOLERANCE_LSB [TOLERANCE_RMS_LSB]]\n", argv[0]);
+        return 2;
+    }
+    tolerance = argc > 3 ? atol(argv[3]) : 0;
+    rms_tolerance = argc > 4 ? atof(argv[4]) : (double) tolerance;
+
+    for (int f = 0; f < 2; ++f) {
+        memset(&info[f], 0, sizeof(info[f]));
+        if ((file[f] = sf_open(argv[f + 1], SFM_READ, &info[f])) == NULL) {
+            fprintf(stderr, "Error: Unable to open input file '%s': %s\n", argv[f + 1], sf_strerror(NULL));
+            return 2;
+        }
+    }
+
+    if (info[0].channels != info[1].channels || info[0].frames != info[1].frames || info[0].channels > 8) {
+        printf("Files differ: %d channels of %ld frames and %d channels of %ld frames\n", info[0].channels,
+               (long) info[0].frames, info[1].channels, (long) info[1].frames);
+        return 1;
+    }
+
+    /* libsndfile returns integer samples left aligned in 32 bits */
+    switch (info[0].format & SF_FORMAT_SUBMASK) {
+        case SF_FORMAT_PCM_16:
+            shift = 16;
+            break;
+        case SF_FORMAT_PCM_24:
+            shift = 8;
+            break;
+        default:
+            shift = 0;
+            break;
+    }
+
+    while (pos < info[0].frames) {
+        frames[0] = sf_readf_int(file[0], block[0], BLOCK_FRAMES);
+        frames[1] = sf_readf_int(file[1], block[1], BLOCK_FRAMES);
+        if (frames[0] <= 0 || frames[0] != frames[1]) {
+            printf("Files differ: reading failed at frame %ld\n", (long) pos);
+            return 1;
+        }
+
+        for (sf_count_t i = 0; i < frames[0] * info[0].channels; ++i) {
+            diff = labs(((long) block[0][i] >> shift) - ((long) block[1][i] >> shift));
+            sum_squares += (double) diff * diff;
+            if (diff > max_diff) {
+                max_diff = diff;
+                max_pos = pos + i / info[0].channels;
+            }
+        }
+        pos += frames[0];
+    }
+
+    sf_close(file[0]);
+    sf_close(file[1]);
+
+    rms = info[0].frames > 0 ? sqrt(sum_squares / ((double) info[0].frames * info[0].channels)) : 0.0;
+
+    printf("Maximum difference %ld LSB at frame %ld, tolerance %ld LSB, RMS difference %.3f LSB, tolerance %.3f LSB\n",
+           max_diff, (long) max_pos, tolerance, rms, rms_tolerance);
+    return max_diff > tolerance || rms > rms_tolerance ? 1 : 0;
+}
@@ -0,0 +1,65 @@
+#!/bin/sh
+# Options of configuration file must have the same effect as options of command line,
+# keys are matched whole, also those which start with another key
+# Usage: config_file.sh TOOLKIT GEN_NOISY WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+dir=$3
+config="$dir/config_test.conf"
+
+"$gen_noisy" "$dir/config_in.wav" 2 16000 2 || exit 1
+
+status=0
+
+# run toolkit with configuration file of given lines, its messages are in $dir/config_test.log
+run_config() {
+    printf '%s\n' "$@" > "$config"
+    "$toolkit" --progress-interval 0 -c "$config" > "$dir/config_test.log" 2>&1
+}
+
+# fail when log contains message
+check_log() {
+    if grep -q "$1" "$dir/config_test.log"; then
+        echo "$2:"
+        cat "$dir/config_test.log"
+        status=1
+    fi
+}
+
+# fail when log does not contain message
+expect_log() {
+    if ! grep -q "$1" "$dir/config_test.log"; then
+        echo "$2:"
+        cat "$dir/config_test.log"
+        status=1
+    fi
+}
+
+# downmix_weights is not the boolean downmix
+"$toolkit" --progress-interval 0 --downmix-weights 0.7,0.3 \
+    --input "$dir/config_in.wav" --output "$dir/config_out.wav" > /dev/null || exit 1
+mv "$dir/config_out.wav" "$dir/config_weights.wav"
+"$toolkit" --progress-interval 0 --downmix \
+    --input "$dir/config_in.wav" --output "$dir/config_out.wav" > /dev/null || exit 1
+mv "$dir/config_out.wav" "$dir/config_mean.wav"
+
+run_config "input_file $dir/config_in.wav" "output_file $dir/config_out.wav" "downmix_weights 0.7,0.3"
+check_log "Unknown" "downmix_weights was not recognized"
+if ! cmp -s "$dir/config_out.wav" "$dir/config_weights.wav" || cmp -s "$dir/config_out.wav" "$dir/config_mean.wav"; then
+    echo "downmix_weights of configuration file differs from --downmix-weights"
+    status=1
+fi
+
+# live_* keys are not the boolean live, values out of range stop toolkit before live stream is opened
+run_config "live true" "live_source setk_in.monitor" "live_sink setk_out" "live_duration -1"
+check_log "Unknown" "live_source or live_sink was not recognized"
+expect_log "'live duration' parameter" "live_duration was not recognized"
+
+run_config "live true" "live_samplerate 0"
+expect_log "'live samplerate' parameter" "live_samplerate was not recognized"
+
+run_config "live true" "live_channels 100"
+expect_log "'live channels' parameter" "live_channels was not recognized"
+
+exit $status
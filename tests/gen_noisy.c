@@ -0,0 +1,106 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* test signal generator, voiced syllables of harmonic tone in white noise, signal is the same
+ * on every run, so that outputs of toolkit may be compared */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <sndfile.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* frames written at once */
+#define BLOCK_FRAMES                        4096
+
+/* uniform noise of linear congruential generator in range <-1, 1> */
+static double noise(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return (double) *state / 2147483648.0 - 1.0;
+}
+
+int main(int argc, char **argv) {
+    SF_INFO info;
+    SNDFILE *file;
+    double seconds, t, envelope, speech;
+    double block[BLOCK_FRAMES * 8];
+    uint32_t state = 12345;
+    sf_count_t frames, pos = 0, n;
+    int format;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s FILE SECONDS [SAMPLERATE [CHANNELS [pcm16|pcm24|float]]]\n", argv[0]);
+        return 1;
+    }
+
+    memset(&info, 0, sizeof(info));
+    seconds = atof(argv[2]);
+    info.samplerate = argc > 3 ? atoi(argv[3]) : 16000;
+    info.channels = argc > 4 ? atoi(argv[4]) : 1;
+
+    if (argc > 5 && strcmp(argv[5], "pcm24") == 0)
+        format = SF_FORMAT_PCM_24;
+    else if (argc > 5 && strcmp(argv[5], "float") == 0)
+        format = SF_FORMAT_FLOAT;
+    else
+        format = SF_FORMAT_PCM_16;
+    info.format = SF_FORMAT_WAV | format;
+
+    if (info.channels < 1 || info.channels > 8 || info.samplerate <= 0 || seconds <= 0) {
+        fprintf(stderr, "Error: Invalid signal parameters.\n");
+        return 1;
+    }
+
+    if ((file = sf_open(argv[1], SFM_WRITE, &info)) == NULL) {
+        fprintf(stderr, "Error: Unable to open output file '%s': %s\n", argv[1], sf_strerror(NULL));
+        return 1;
+    }
+
+    frames = (sf_count_t) (seconds * info.samplerate);
+    while (pos < frames) {
+        n = frames - pos < BLOCK_FRAMES ? frames - pos : BLOCK_FRAMES;
+
+        for (sf_count_t i = 0; i < n; ++i) {
+            t = (double) (pos + i) / info.samplerate;
+
+            /* syllables of 150 ms with pauses, noise alone is heard in pauses */
+            envelope = fmod(t, 0.4) < 0.15 ? sin(M_PI * fmod(t, 0.4) / 0.15) : 0.0;
+            speech = 0.0;
+            for (int h = 1; h <= 5; ++h)
+                speech += sin(2 * M_PI * 140.0 * h * t) / h;
+
+            /* channels have the same speech and their own noise */
+            for (int ch = 0; ch < info.channels; ++ch)
+                block[i * info.channels + ch] = 0.3 * envelope * speech * (1.0 - 0.2 * ch) + 0.05 * noise(&state);
+        }
+
+        if (sf_writef_double(file, block, n) != n) {
+            fprintf(stderr, "Error: Unable to write output file '%s': %s\n", argv[1], sf_strerror(file));
+            sf_close(file);
+            return 1;
+        }
+        pos += n;
+    }
+
+    sf_close(file);
+    return 0;
+}
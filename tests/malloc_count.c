@@ -0,0 +1,80 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* malloc interposer loaded by LD_PRELOAD, it counts every heap allocation of process, including
+ * those of libc, libsndfile and FFTW, toolkit reads the counter by setk_malloc_count() */
+
+#include <stddef.h>
+#include <errno.h>
+
+/* allocator of glibc */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+/* heap allocations of all threads so far */
+static unsigned long allocations = 0;
+
+/* count one heap allocation */
+static inline void count_allocation(void) {
+    __sync_fetch_and_add(&allocations, 1);
+}
+
+/* heap allocations so far, looked up by toolkit */
+unsigned long setk_malloc_count(void) {
+    return __sync_fetch_and_add(&allocations, 0);
+}
+
+void *malloc(size_t size) {
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    count_allocation();
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+    void *p;
+
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+
+    count_allocation();
+    if ((p = __libc_memalign(alignment, size)) == NULL)
+        return ENOMEM;
+
+    *ptr = p;
+    return 0;
+}
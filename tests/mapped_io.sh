@@ -0,0 +1,28 @@
+#!/bin/sh
+# Memory mapped input and output must convert samples exactly as libsndfile does,
+# so output of mapped files is the same as output of --no-mmap
+# Usage: mapped_io.sh TOOLKIT GEN_NOISY AUDIO_DIFF WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+audio_diff=$3
+dir=$4
+
+status=0
+for format in pcm16 pcm24; do
+    "$gen_noisy" "$dir/mapped_in.wav" 3 16000 2 $format || exit 1
+
+    for algorithm in specsub mmse wiener-iter; do
+        "$toolkit" --progress-interval 0 --snd-enhance $algorithm \
+            --input "$dir/mapped_in.wav" --output "$dir/mapped_out.wav" > /dev/null || exit 1
+        "$toolkit" --progress-interval 0 --snd-enhance $algorithm --no-mmap \
+            --input "$dir/mapped_in.wav" --output "$dir/mapped_ref.wav" > /dev/null || exit 1
+
+        if ! "$audio_diff" "$dir/mapped_ref.wav" "$dir/mapped_out.wav" 0; then
+            echo "$format $algorithm: mapped output differs from libsndfile output"
+            status=1
+        fi
+    done
+done
+
+exit $status
@@ -0,0 +1,52 @@
+#!/bin/sh
+# Noise profile saved after the last frame of one file must start noise estimation of another
+# file, output differs from estimation which starts anew, profile is loaded the same way every
+# time and a profile of another estimator or samplerate is refused
+# Usage: noise_profile.sh TOOLKIT GEN_NOISY AUDIO_DIFF WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+audio_diff=$3
+dir=$4
+
+status=0
+"$gen_noisy" "$dir/profile_noise.wav" 3 16000 1 pcm16 || exit 1
+"$gen_noisy" "$dir/profile_in.wav" 5 16000 1 pcm16 || exit 1
+"$gen_noisy" "$dir/profile_in8k.wav" 1 8000 1 pcm16 || exit 1
+
+for estimator in vad doblinger mcra mcra2; do
+    "$toolkit" --progress-interval 0 --noise-est $estimator --input "$dir/profile_noise.wav" \
+        --output "$dir/profile_out.wav" --save-noise-profile "$dir/profile_1.prof" > /dev/null || exit 1
+
+    # profile is loaded and saved again after the same file twice
+    for run in 1 2; do
+        "$toolkit" --progress-interval 0 --noise-est $estimator --input "$dir/profile_in.wav" \
+            --output "$dir/profile_out_$run.wav" --noise-profile "$dir/profile_1.prof" \
+            --save-noise-profile "$dir/profile_2_$run.prof" > /dev/null || exit 1
+    done
+    "$toolkit" --progress-interval 0 --noise-est $estimator --input "$dir/profile_in.wav" \
+        --output "$dir/profile_ref.wav" > /dev/null || exit 1
+
+    if ! "$audio_diff" "$dir/profile_out_1.wav" "$dir/profile_out_2.wav" 0 0 > /dev/null ||
+        ! cmp -s "$dir/profile_2_1.prof" "$dir/profile_2_2.prof"; then
+        echo "$estimator: loaded profile gives different output or state on every run"
+        status=1
+    fi
+    if "$audio_diff" "$dir/profile_ref.wav" "$dir/profile_out_1.wav" 0 0 > /dev/null; then
+        echo "$estimator: loaded profile does not change output"
+        status=1
+    fi
+
+    if "$toolkit" --progress-interval 0 --noise-est hirsch --input "$dir/profile_in.wav" \
+        --output "$dir/profile_out.wav" --noise-profile "$dir/profile_1.prof" > /dev/null; then
+        echo "$estimator: profile is loaded by hirsch noise estimation"
+        status=1
+    fi
+    if "$toolkit" --progress-interval 0 --noise-est $estimator --input "$dir/profile_in8k.wav" \
+        --output "$dir/profile_out.wav" --noise-profile "$dir/profile_1.prof" > /dev/null; then
+        echo "$estimator: profile of 16000 Hz is loaded at 8000 Hz"
+        status=1
+    fi
+done
+
+exit $status
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Audio piped through stdin and stdout must be enhanced as the same file, output on stdout is
+# headerless PCM of input format and all messages go to stderr, so it must equal the samples
+# at the end of output file, which follow its header
+# Usage: pipe_mode.sh TOOLKIT GEN_NOISY WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+dir=$3
+
+status=0
+# 5 s of 16 bit stereo at 16 kHz
+bytes=320000
+"$gen_noisy" "$dir/pipe_in.wav" 5 16000 2 pcm16 || exit 1
+tail -c $bytes "$dir/pipe_in.wav" > "$dir/pipe_in.raw"
+
+"$toolkit" --progress-interval 0 --input "$dir/pipe_in.wav" --output "$dir/pipe_ref.wav" > /dev/null || exit 1
+tail -c $bytes "$dir/pipe_ref.wav" > "$dir/pipe_ref.raw"
+
+# fail unless output on stdout has every sample of output file
+check_output() {
+    if ! cmp -s "$dir/pipe_ref.raw" "$dir/pipe_out.raw"; then
+        echo "$1: output on stdout differs from output file"
+        status=1
+    fi
+}
+
+"$toolkit" -v --input - --output - < "$dir/pipe_in.wav" > "$dir/pipe_out.raw" 2> "$dir/pipe.log" || exit 1
+check_output "WAV on stdin"
+
+"$toolkit" -v --raw-samplerate 16000 --raw-channels 2 --input - --output - < "$dir/pipe_in.raw" \
+    > "$dir/pipe_out.raw" 2> "$dir/pipe.log" || exit 1
+check_output "headerless PCM on stdin"
+
+exit $status
@@ -0,0 +1,49 @@
+#!/bin/sh
+# Output must never be the input file, also when it is reached by a link or another path,
+# as output is truncated before input is read, nor the output of another file of batch
+# Usage: same_file.sh TOOLKIT GEN_NOISY WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+dir=$3/same_file
+
+rm -rf "$dir"
+mkdir -p "$dir/batch" || exit 1
+"$gen_noisy" "$dir/in.wav" 1 || exit 1
+cp "$dir/in.wav" "$dir/batch/in.wav" || exit 1
+ln -s in.wav "$dir/link.wav" || exit 1
+
+status=0
+
+# fail unless toolkit failed, reported the same file and left input untouched
+check_run() {
+    if [ "$1" -eq 0 ] || ! grep -q "same file" "$dir/same_file.log" || ! cmp -s "$dir/in.wav" "$2"; then
+        echo "$3:"
+        cat "$dir/same_file.log"
+        status=1
+    fi
+}
+
+"$toolkit" --progress-interval 0 --input "$dir/in.wav" --output "$dir/link.wav" > "$dir/same_file.log" 2>&1
+check_run $? "$dir/in.wav" "output is symbolic link to input"
+
+"$toolkit" --progress-interval 0 --input "$dir/in.wav" --output "$dir/../same_file/in.wav" \
+    > "$dir/same_file.log" 2>&1
+check_run $? "$dir/in.wav" "output is another path of input"
+
+"$toolkit" --progress-interval 0 --batch "$dir/batch" --output "$dir/batch/." > "$dir/same_file.log" 2>&1
+check_run $? "$dir/batch/in.wav" "output directory of batch is directory of input"
+
+# inputs of the same name in two directories collide in output directory, batch is refused
+mkdir -p "$dir/a" "$dir/b" "$dir/out" || exit 1
+cp "$dir/in.wav" "$dir/a/x.wav" && cp "$dir/in.wav" "$dir/b/x.wav" || exit 1
+printf '%s\n%s\n' "$dir/a/x.wav" "$dir/b/x.wav" > "$dir/list.txt"
+if "$toolkit" --progress-interval 0 --batch "$dir/list.txt" --output "$dir/out" > "$dir/same_file.log" 2>&1 ||
+    ! grep -q "^Error: Several files of batch would be written to '$dir/out/x.wav'" "$dir/same_file.log" ||
+    [ -e "$dir/out/x.wav" ]; then
+    echo "batch inputs of the same name in one output directory:"
+    cat "$dir/same_file.log"
+    status=1
+fi
+
+exit $status
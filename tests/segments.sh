@@ -0,0 +1,50 @@
+#!/bin/sh
+# Segments must be close to one pass, noise estimation of every segment starts anew during
+# its pre-roll, so each estimator has its own pre-roll in ms and tolerance in LSB of 16 bit
+# output, maximum and RMS difference over whole file:
+#   vad        converges within default pre-roll
+#   doblinger  and mcra2 converge slowly, smoothing of noise spans seconds
+#   mcra       holds its estimate during speech, so it needs long pre-roll, pre-roll of 950
+#              hops starts segments in the middle of window of minimum search of one pass
+# a priori SNR of decision directed mmse and wiener-as is warmed up during pre-roll too
+# hirsch does not converge at all, so segments are refused unless noise is estimated in two passes
+# Files which can not be memory mapped are processed in one pass with a warning
+# Usage: segments.sh TOOLKIT GEN_NOISY AUDIO_DIFF WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+audio_diff=$3
+dir=$4
+
+status=0
+"$gen_noisy" "$dir/segments_in.wav" 40 16000 1 pcm16 || exit 1
+
+for estimator in "vad 2000 2 0.1" "doblinger 2000 100 4" "mcra2 2000 350 14" "mcra 9500 4 0.2"; do
+    set -- $estimator
+    for algorithm in specsub mmse wiener-as; do
+        "$toolkit" --progress-interval 0 --snd-enhance $algorithm --noise-est $1 \
+            --input "$dir/segments_in.wav" --output "$dir/segments_ref.wav" > /dev/null || exit 1
+        "$toolkit" --progress-interval 0 --snd-enhance $algorithm --noise-est $1 --segments 4 \
+            --segment-preroll $2 --input "$dir/segments_in.wav" --output "$dir/segments_out.wav" > /dev/null || exit 1
+
+        if ! "$audio_diff" "$dir/segments_ref.wav" "$dir/segments_out.wav" $3 $4; then
+            echo "$algorithm $1: output of segments differs from one pass"
+            status=1
+        fi
+    done
+done
+
+"$toolkit" --progress-interval 0 --segments 4 --no-mmap \
+    --input "$dir/segments_in.wav" --output "$dir/segments_out.wav" > "$dir/segments.log" || exit 1
+if ! grep -q "^Warning: .* processed in one pass instead of 4 segments" "$dir/segments.log"; then
+    echo "segments of file, which is not memory mapped: fallback to one pass is not reported"
+    status=1
+fi
+
+if "$toolkit" --progress-interval 0 --segments 4 --noise-est hirsch \
+    --input "$dir/segments_in.wav" --output "$dir/segments_out.wav" > "$dir/segments.log"; then
+    echo "segments with hirsch noise estimation are not refused"
+    status=1
+fi
+
+exit $status
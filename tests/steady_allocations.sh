@@ -0,0 +1,30 @@
+#!/bin/sh
+# Heap allocations after the first block are counted at allocator by malloc_count library,
+# every algorithm must process the rest of input without allocation
+# Usage: steady_allocations.sh TOOLKIT GEN_NOISY MALLOC_COUNT WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+malloc_count=$3
+dir=$4
+
+"$gen_noisy" "$dir/steady_in.wav" 12 16000 2 || exit 1
+
+status=0
+for mode in "" "--no-mmap" "--async-io" "--channel-threads 2"; do
+    for algorithm in specsub mmse wiener-as wiener-iter residual; do
+        for estimator in vad mcra2; do
+            report=$(LD_PRELOAD="$malloc_count" "$toolkit" -v $mode \
+                     --snd-enhance $algorithm --noise-est $estimator \
+                     --input "$dir/steady_in.wav" --output "$dir/steady_out.wav" |
+                     grep "^Heap allocations after first block:")
+
+            if [ "$report" != "Heap allocations after first block: 0" ]; then
+                echo "$algorithm $estimator $mode: ${report:-allocations were not counted}"
+                status=1
+            fi
+        done
+    done
+done
+
+exit $status
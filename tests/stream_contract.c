@@ -0,0 +1,175 @@
+/*
+** Copyright (C) 2011 Vladimir Zahradnik <vladimir.zahradnik@gmail.com>
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 2 or version 3 of the
+** License.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* client of libsetk, which checks contract of push, pull and flush: input file is pushed
+ * to stream twice in buffers of varying size, output is pulled after every push, output
+ * of each stream has as many frames as input and the second stream, which is pushed after
+ * flush, starts anew, so its output is the same as of the first one, which is written
+ * to output file in format of input */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sndfile.h>
+
+#include "setk.h"
+
+/* sizes of pushed buffers in frames, they are used in turn */
+static const size_t push_sizes[] = {1, 37, 160, 1000, 4095, 333};
+
+/* pull every available frame of stream into output from frame pos, returns new pos,
+ * pulls are limited to 100 frames, so that output is pulled in parts too */
+static size_t pull_available(setk_stream_t *stream, setk_sample_t *output, size_t pos, size_t frames,
+                             int *status) {
+    size_t available = setk_stream_available(stream), pulled;
+    int channels = setk_stream_channels(stream);
+
+    if (pos + available > frames) {
+        printf("Stream has %zu frames of output after %zu frames, input has only %zu frames\n", available, pos,
+               frames);
+        *status = 1;
+        return pos;
+    }
+
+    while (available > 0) {
+        pulled = setk_stream_pull(stream, output + pos * channels, available < 100 ? available : 100);
+        if (pulled == 0) {
+            printf("Pull returned no frames, %zu frames were available\n", available);
+            *status = 1;
+            return pos;
+        }
+        pos += pulled;
+        available -= pulled;
+    }
+
+    if (setk_stream_available(stream) != 0) {
+        printf("Stream has output after all available frames were pulled\n");
+        *status = 1;
+    }
+
+    return pos;
+}
+
+/* push input to stream and pull its output, returns number of output frames */
+static size_t enhance(setk_stream_t *stream, const setk_sample_t *input, setk_sample_t *output, size_t frames,
+                      int channels, int *status) {
+    size_t in_pos = 0, out_pos = 0, n;
+    setk_status_t err;
+
+    for (int k = 0; in_pos < frames; ++k) {
+        n = push_sizes[k % (sizeof(push_sizes) / sizeof(push_sizes[0]))];
+        n = frames - in_pos < n ? frames - in_pos : n;
+
+        if ((err = setk_stream_push(stream, input + in_pos * channels, n)) != SETK_OK) {
+            printf("Push failed: %s\n", setk_strerror(err));
+            *status = 1;
+            return out_pos;
+        }
+        in_pos += n;
+        out_pos = pull_available(stream, output, out_pos, frames, status);
+    }
+
+    if ((err = setk_stream_flush(stream)) != SETK_OK) {
+        printf("Flush failed: %s\n", setk_strerror(err));
+        *status = 1;
+        return out_pos;
+    }
+
+    return pull_available(stream, output, out_pos, frames, status);
+}
+
+int main(int argc, char **argv) {
+    SF_INFO info;
+    SNDFILE *file;
+    setk_stream_t *stream;
+    setk_sample_t *input, *output[2];
+    size_t frames, out_frames;
+    setk_status_t err;
+    int status = 0;
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s INPUT OUTPUT\n", argv[0]);
+        return 2;
+    }
+
+    memset(&info, 0, sizeof(info));
+    if ((file = sf_open(argv[1], SFM_READ, &info)) == NULL) {
+        fprintf(stderr, "Error: Unable to open input file '%s': %s\n", argv[1], sf_strerror(NULL));
+        return 2;
+    }
+
+    frames = (size_t) info.frames;
+    input = (setk_sample_t *) malloc(sizeof(*input) * frames * info.channels);
+    output[0] = (setk_sample_t *) calloc(frames * info.channels, sizeof(*output[0]));
+    output[1] = (setk_sample_t *) calloc(frames * info.channels, sizeof(*output[1]));
+    if (input == NULL || output[0] == NULL || output[1] == NULL) {
+        fprintf(stderr, "Error: malloc() failed\n");
+        return 2;
+    }
+
+#ifdef SETK_SINGLE_PRECISION
+    if (sf_readf_float(file, input, info.frames) != info.frames) {
+#else
+    if (sf_readf_double(file, input, info.frames) != info.frames) {
+#endif
+        fprintf(stderr, "Error: Unable to read input file '%s': %s\n", argv[1], sf_strerror(file));
+        return 2;
+    }
+    sf_close(file);
+
+    if ((err = setk_stream_create(&stream, info.samplerate, info.channels, NULL)) != SETK_OK) {
+        fprintf(stderr, "Error: Unable to create stream: %s\n", setk_strerror(err));
+        return 2;
+    }
+
+    /* the second stream is pushed after flush of the first one */
+    for (int run = 0; run < 2; ++run) {
+        out_frames = enhance(stream, input, output[run], frames, info.channels, &status);
+        if (out_frames != frames) {
+            printf("Stream %d: output has %zu frames, input has %zu frames\n", run + 1, out_frames, frames);
+            status = 1;
+        }
+    }
+
+    if (memcmp(output[0], output[1], sizeof(*output[0]) * frames * info.channels) != 0) {
+        printf("Output of stream pushed after flush differs from output of the first stream\n");
+        status = 1;
+    }
+
+    setk_stream_destroy(stream);
+    setk_cleanup();
+
+    if ((file = sf_open(argv[2], SFM_WRITE, &info)) == NULL) {
+        fprintf(stderr, "Error: Unable to open output file '%s': %s\n", argv[2], sf_strerror(NULL));
+        return 2;
+    }
+#ifdef SETK_SINGLE_PRECISION
+    if (sf_writef_float(file, output[0], info.frames) != info.frames) {
+#else
+    if (sf_writef_double(file, output[0], info.frames) != info.frames) {
+#endif
+        fprintf(stderr, "Error: Unable to write output file '%s': %s\n", argv[2], sf_strerror(file));
+        status = 2;
+    }
+    sf_close(file);
+
+    free(input);
+    free(output[0]);
+    free(output[1]);
+
+    return status;
+}
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Client of libsetk pushes file in buffers of varying size and pulls its output, output must
+# have as many frames as input, stream pushed after flush must start anew and output must be
+# the same as of toolkit, which enhances the file with the same default options
+# Usage: stream_contract.sh TOOLKIT GEN_NOISY AUDIO_DIFF STREAM_CONTRACT WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+audio_diff=$3
+stream_contract=$4
+dir=$5
+
+"$gen_noisy" "$dir/stream_in.wav" 3 16000 2 pcm16 || exit 1
+"$toolkit" --progress-interval 0 --input "$dir/stream_in.wav" --output "$dir/stream_ref.wav" > /dev/null || exit 1
+
+"$stream_contract" "$dir/stream_in.wav" "$dir/stream_out.wav" || exit 1
+
+if ! "$audio_diff" "$dir/stream_ref.wav" "$dir/stream_out.wav" 0 0; then
+    echo "output of libsetk stream differs from toolkit"
+    exit 1
+fi
+
+exit 0
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Two-pass mode takes noise of every hop from the first pass, so segments need no warm-up of
+# noise estimation, output of every algorithm must be the same as in one pass, also of mmse,
+# whose a priori SNR is warmed up during pre-roll
+# Files which can not be memory mapped are processed in one pass with a warning
+# Usage: two_pass.sh TOOLKIT GEN_NOISY AUDIO_DIFF WORK_DIR
+
+toolkit=$1
+gen_noisy=$2
+audio_diff=$3
+dir=$4
+
+status=0
+"$gen_noisy" "$dir/two_pass_in.wav" 20 16000 1 pcm16 || exit 1
+
+for estimator in vad mcra; do
+    for algorithm in specsub wiener-iter mmse; do
+        "$toolkit" --progress-interval 0 --snd-enhance $algorithm --noise-est $estimator \
+            --input "$dir/two_pass_in.wav" --output "$dir/two_pass_ref.wav" > /dev/null || exit 1
+        "$toolkit" --progress-interval 0 --snd-enhance $algorithm --noise-est $estimator --two-pass --segments 4 \
+            --input "$dir/two_pass_in.wav" --output "$dir/two_pass_out.wav" > /dev/null || exit 1
+
+        if ! "$audio_diff" "$dir/two_pass_ref.wav" "$dir/two_pass_out.wav" 0 0; then
+            echo "$algorithm $estimator: output of two passes differs from one pass"
+            status=1
+        fi
+    done
+done
+
+"$toolkit" --progress-interval 0 --two-pass --no-mmap \
+    --input "$dir/two_pass_in.wav" --output "$dir/two_pass_out.wav" > "$dir/two_pass.log" || exit 1
+if ! grep -q "^Warning: .* processed in one pass instead of two" "$dir/two_pass.log"; then
+    echo "two passes of file, which is not memory mapped: fallback to one pass is not reported"
+    status=1
+fi
+
+exit $status